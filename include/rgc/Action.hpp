@@ -1,8 +1,11 @@
 #ifndef RENDERGRAPHCOMPILER_ACTION_HPP
 #define RENDERGRAPHCOMPILER_ACTION_HPP
 
+#include <algorithm>
+#include <cstdint>
 #include <memory>
 #include <ostream>
+#include <ranges>
 #include <span>
 #include <vector>
 
@@ -13,6 +16,22 @@
 namespace rgc {
 
 class Value;
+class Graph;
+
+/**
+ * @class InlineOperands
+ *
+ * Uses of an action with a fixed number of operands. It is a base of such
+ * actions rather than a member, so that a Use finds its user with a
+ * static_cast from its own address.
+ *
+ */
+template <unsigned N> class InlineOperands {
+  friend class Action;
+  friend class Use;
+
+  Use m_operands[N];
+};
 
 /**
  * @class Action
@@ -33,33 +52,103 @@ class Value;
  * 4) Terminator - last use point for resource. Value of terminator
  * must not be used further.
  *
+ * Terminators and RealActions have a fixed number of operands and store
+ * their Uses inside of the action (see InlineOperands). Compositions and
+ * dynamic Allocations allocate an exactly sized block of Uses with
+ * m_allocateOperands. Action itself keeps only the number of operands,
+ * packed with the kind tags.
+ *
  */
 class Action : public IListNode<Action>, public Value {
 public:
-  enum Kind { Allocation, Composition, RealAction, Terminator };
+  enum Kind : std::uint8_t { Allocation, Composition, RealAction, Terminator };
 
   Action(Kind kind, Type *type) : Value(type), m_kind(kind){};
 
-  std::span<Value *const> uses() const { return m_uses; }
+  /**
+   * @return values used by this action in operand order.
+   */
+  auto uses() const {
+    return operands() | std::views::transform(&Use::value);
+  }
+
+  std::span<const Use> operands() const {
+    return {m_uses(), m_numOperands};
+  }
 
-  void replaceUse(unsigned Index, Value *value) { m_uses.at(Index) = value; }
+  void replaceUse(unsigned Index, Value *value);
 
   auto actionKind() const { return m_kind; }
 
-  void dump(std::ostream &os) const override;
+  /**
+   * @return new action of the same class and with the same properties,
+   * using given operands instead of this action's ones. Clone is not
+   * inserted in any graph.
+   *
+   * Every class of actions that may be cloned must override it, including
+   * subclasses without state of their own: cloning an action whose class
+   * doesn't override it is an error rather than returning an action of its
+   * base class.
+   */
+  virtual Action *clone(std::span<Value *const> operands) const;
+
+  /**
+   * Appends state of this action that is not captured by its class, type
+   * and operands, such as subresource ranges, to words describing graph
+   * structure (see StructuralKey). Subclasses with own state must extend it
+   * and report every change of it with m_changed.
+   */
+  virtual void properties(std::vector<std::uint64_t> & /*words*/) const {}
 
-  ~Action() override;
+  /**
+   * @return Graph this action is currently inserted in or nullptr
+   * if action is not a part of any graph.
+   */
+  Graph *graph() const;
+
+  void dump(std::ostream &os) const override;
 
 protected:
-  void m_push_use(Value *v) {
-    assert(v && "value cannot be nullptr");
-    v->addUser(this, m_uses.size());
-    m_uses.push_back(v);
+  /**
+   * Tags uses stored inside of the action with its kind and operand index
+   * and links them to values.
+   */
+  template <unsigned N>
+  void m_setOperands(InlineOperands<N> &storage,
+                     std::span<Value *const> values) {
+    assert(values.size() == N && "operand count mismatch");
+    auto first = m_kind == Kind::Terminator ? Use::Tag::TerminatorUse
+                                            : Use::Tag::RealActionUseDef;
+    m_numOperands = N;
+    for (unsigned i = 0; i < N; ++i) {
+      assert(values[i] && "value cannot be nullptr");
+      auto &use = storage.m_operands[i];
+      use.m_prevAndTag = static_cast<std::uintptr_t>(first) + i;
+      use.m_set(values[i]);
+    }
   }
 
+  /**
+   * Allocates a block of uses linked to values and followed by a pointer to
+   * this action. The block must be released with m_freeOperands.
+   */
+  Use *m_allocateOperands(std::span<Value *const> values);
+
+  void m_freeOperands(Use *uses);
+
+  /// Invalidates structure cached by the graph the action is inserted in.
+  void m_changed();
+
+  /// Spare bits next to the kind, which subclasses pack their own tags in
+  std::uint8_t m_subclassData = 0;
+
 private:
-  std::vector<Value *> m_uses;
+  friend class Use;
+
+  Use *m_uses() const;
+
   Kind m_kind;
+  std::uint32_t m_numOperands = 0;
 };
 
 /**
@@ -78,19 +167,30 @@ private:
  */
 class Allocation : public Action {
 public:
-  enum Kind { Static, Dynamic };
+  enum Kind : std::uint8_t { Static, Dynamic };
 
-  explicit Allocation(Type *type)
-      : Action(Action::Kind::Allocation, type), m_kind(Kind::Static) {}
+  explicit Allocation(Type *type) : Action(Action::Kind::Allocation, type) {}
 
   explicit Allocation(Type *type, Value *use)
-      : Action(Action::Kind::Allocation, type), m_kind(Kind::Dynamic) {
-    m_push_use(use);
+      : Action(Action::Kind::Allocation, type),
+        m_storage(m_allocateOperands({&use, 1})) {}
+
+  auto allocationKind() const {
+    return m_storage ? Kind::Dynamic : Kind::Static;
+  }
+
+  Action *clone(std::span<Value *const> operands) const override;
+
+  ~Allocation() override {
+    if (m_storage)
+      m_freeOperands(m_storage);
   }
-  auto allocationKind() const { return m_kind; }
 
 private:
-  Kind m_kind;
+  friend class Action;
+
+  /// Stays nullptr for static allocations
+  Use *m_storage = nullptr;
 };
 
 /**
@@ -102,11 +202,103 @@ private:
  */
 class Composition : public Action {
 public:
-  Composition(Type *type, std::span<Value *> uses)
-      : Action(Action::Kind::Composition, type) {
-    for (auto &&use : uses)
-      m_push_use(use);
+  Composition(Type *type, std::span<Value *const> uses)
+      : Action(Action::Kind::Composition, type),
+        m_storage(m_allocateOperands(uses)) {}
+
+  Action *clone(std::span<Value *const> operands) const override;
+
+  ~Composition() override { m_freeOperands(m_storage); }
+
+private:
+  friend class Action;
+
+  Use *m_storage;
+};
+
+/**
+ * @struct SubresourceRange
+ *
+ * Range of mip levels and array layers of an image. Count equal to All
+ * extends range up to the last mip level/array layer. Resources other than
+ * images have exactly one mip level and one array layer.
+ *
+ */
+struct SubresourceRange {
+  static constexpr std::uint16_t All = 0xFFFFu;
+
+  std::uint16_t baseMipLevel = 0;
+  std::uint16_t mipLevelCount = All;
+  std::uint16_t baseArrayLayer = 0;
+  std::uint16_t arrayLayerCount = All;
+
+  static constexpr SubresourceRange mips(std::uint16_t base,
+                                         std::uint16_t count = 1) {
+    return {base, count, 0, All};
+  }
+
+  static constexpr SubresourceRange layers(std::uint16_t base,
+                                           std::uint16_t count = 1) {
+    return {0, All, base, count};
   }
+
+  static constexpr SubresourceRange none() { return {0, 0, 0, 0}; }
+
+  constexpr bool empty() const {
+    return mipLevelCount == 0 || arrayLayerCount == 0;
+  }
+
+  constexpr bool whole() const {
+    return baseMipLevel == 0 && mipLevelCount == All && baseArrayLayer == 0 &&
+           arrayLayerCount == All;
+  }
+
+  /**
+   * @return true if range is not empty and lies within resource with given
+   * number of mip levels and array layers.
+   */
+  constexpr bool within(unsigned mipLevels, unsigned arrayLayers) const {
+    auto withinOne = [](unsigned base, unsigned count, unsigned limit) {
+      return base < limit && count != 0 &&
+             (count == All || base + count <= limit);
+    };
+    return withinOne(baseMipLevel, mipLevelCount, mipLevels) &&
+           withinOne(baseArrayLayer, arrayLayerCount, arrayLayers);
+  }
+
+  /**
+   * @return range clamped to resource with given number of mip levels and
+   * array layers.
+   */
+  constexpr SubresourceRange clamp(unsigned mipLevels,
+                                   unsigned arrayLayers) const {
+    auto clampOne = [](unsigned base, unsigned count, unsigned limit) {
+      base = std::min(base, limit);
+      count = std::min(count, limit - base);
+      return std::pair{static_cast<std::uint16_t>(base),
+                       static_cast<std::uint16_t>(count)};
+    };
+    auto [mip, mipCount] = clampOne(baseMipLevel, mipLevelCount, mipLevels);
+    auto [layer, layerCount] =
+        clampOne(baseArrayLayer, arrayLayerCount, arrayLayers);
+    return {mip, mipCount, layer, layerCount};
+  }
+
+  bool operator==(const SubresourceRange &another) const = default;
+};
+
+/**
+ * How an action accesses an image through one of its uses. Unknown usage
+ * is served by General layout.
+ */
+enum class AccessUsage : std::uint8_t {
+  Unknown,
+  ColorAttachment,
+  DepthStencilAttachment,
+  Sampled,
+  Storage,
+  TransferSrc,
+  TransferDst
 };
 
 /**
@@ -119,18 +311,83 @@ public:
  * RealAction also has a 'use' value, for any resource of which it is
  * strictly a point of use.
  * 'use' value may be a constant of NullType.
+ *
+ * By default RealAction modifies whole useDef resource and reads whole 'use'
+ * resource. Narrower subresource ranges may be set for both, so that actions
+ * touching disjoint mip levels or array layers of the same image do not
+ * depend on each other. Subresources of useDef resource that the action
+ * only reads, like the previous mip level while generating a mip chain, go
+ * into its read range, which is empty by default.
+ *
+ * Both uses may be annotated with AccessUsage, which lets layouts of images
+ * be planned ahead (see planLayouts). Read range of useDef resource is
+ * accessed the same way as 'use' resource.
  */
-class RealAction : public Action {
+class RealAction : public Action, public InlineOperands<2> {
 public:
-  RealAction(Value *useDef, Value *use)
-      : Action(Action::Kind::RealAction, useDef->type()) {
-    m_push_use(useDef);
-    m_push_use(use);
+  RealAction(Value *useDef, Value *use, SubresourceRange range = {},
+             SubresourceRange useRange = {},
+             SubresourceRange readRange = SubresourceRange::none())
+      : Action(Action::Kind::RealAction, useDef->type()), m_range(range),
+        m_useRange(useRange), m_readRange(readRange) {
+    Value *operands[] = {useDef, use};
+    m_setOperands(*this, operands);
   }
 
   auto *getUseDef() const { return uses()[0]; }
 
   auto *getUse() const { return uses()[1]; }
+
+  /**
+   * @return subresources of useDef resource modified by this action.
+   */
+  auto &range() const { return m_range; }
+
+  /**
+   * @return subresources of 'use' resource read by this action.
+   */
+  auto &useRange() const { return m_useRange; }
+
+  /**
+   * @return subresources of useDef resource read, but not modified, by this
+   * action.
+   */
+  auto &readRange() const { return m_readRange; }
+
+  /**
+   * @return how useDef resource is accessed by this action.
+   */
+  auto access() const {
+    return static_cast<AccessUsage>(m_subclassData & 0xFu);
+  }
+
+  /**
+   * @return how 'use' resource is accessed by this action.
+   */
+  auto useAccess() const {
+    return static_cast<AccessUsage>(m_subclassData >> 4u);
+  }
+
+  void setAccess(AccessUsage access) {
+    m_subclassData = (m_subclassData & 0xF0u) | static_cast<unsigned>(access);
+    m_changed();
+  }
+
+  void setUseAccess(AccessUsage access) {
+    m_subclassData =
+        (m_subclassData & 0xFu) | (static_cast<unsigned>(access) << 4u);
+    m_changed();
+  }
+
+  Action *clone(std::span<Value *const> operands) const override;
+
+  void properties(std::vector<std::uint64_t> &words) const override;
+
+private:
+  // Both AccessUsages are packed in m_subclassData
+  SubresourceRange m_range;
+  SubresourceRange m_useRange;
+  SubresourceRange m_readRange;
 };
 
 /**
@@ -140,14 +397,67 @@ public:
  * point. Type of all terminators is NullType.
  *
  */
-class Terminator : public Action {
+class Terminator : public Action, public InlineOperands<1> {
 public:
   explicit Terminator(TypePool &tp, Value *use)
-      : Action(Action::Kind::Terminator, tp.get<NullType>()) {
-    m_push_use(use);
+      : Terminator(tp.get<NullType>(), use) {}
+
+  Action *clone(std::span<Value *const> operands) const override;
+
+private:
+  Terminator(Type *type, Value *use)
+      : Action(Action::Kind::Terminator, type) {
+    m_setOperands(*this, {&use, 1});
   }
 };
 
+inline Use *Action::m_uses() const {
+  auto *self = const_cast<Action *>(this);
+  switch (m_kind) {
+  case Kind::Allocation:
+    return static_cast<rgc::Allocation *>(self)->m_storage;
+  case Kind::Composition:
+    return static_cast<rgc::Composition *>(self)->m_storage;
+  case Kind::RealAction:
+    return static_cast<rgc::RealAction *>(self)->m_operands;
+  case Kind::Terminator:
+    return static_cast<rgc::Terminator *>(self)->m_operands;
+  }
+  return nullptr;
+}
+
+inline Action *Use::user() const {
+  auto *self = const_cast<Use *>(this);
+  switch (m_tag()) {
+  case Tag::TerminatorUse:
+    return static_cast<Terminator *>(
+        reinterpret_cast<InlineOperands<1> *>(self));
+  case Tag::RealActionUseDef:
+    return static_cast<RealAction *>(
+        reinterpret_cast<InlineOperands<2> *>(self));
+  case Tag::RealActionUse:
+    return static_cast<RealAction *>(
+        reinterpret_cast<InlineOperands<2> *>(self - 1));
+  default:
+    return *reinterpret_cast<Action *const *>(m_blockEnd());
+  }
+}
+
+inline unsigned Use::index() const {
+  switch (m_tag()) {
+  case Tag::TerminatorUse:
+  case Tag::RealActionUseDef:
+    return 0;
+  case Tag::RealActionUse:
+    return 1;
+  default: {
+    auto *end = m_blockEnd();
+    auto *user = *reinterpret_cast<Action *const *>(end);
+    return user->m_numOperands - static_cast<unsigned>(end - this);
+  }
+  }
+}
+
 } // namespace rgc
 
 #endif // RENDERGRAPHCOMPILER_ACTION_HPP
@@ -0,0 +1,74 @@
+#ifndef RENDERGRAPHCOMPILER_BUDGET_HPP
+#define RENDERGRAPHCOMPILER_BUDGET_HPP
+
+#include <vector>
+
+#include "rgc/Graph.hpp"
+#include "rgc/Partitioning.hpp"
+#include "rgc/Resolution.hpp"
+
+namespace rgc {
+
+struct BudgetOptions {
+  /// Cost of recomputing an action. Every action costs 1 if not set.
+  ActionCost cost;
+  /// Cost of moving one byte between Device and Host, in ActionCost units.
+  double byteCost = 1e-6;
+  /// Reorder the graph for memory (see reorderForMemory) before splitting
+  /// any lifetime.
+  bool reorder = true;
+  /// Allow spilling resources to Host owned buffers.
+  bool spill = true;
+  /// Sizes of screen buffer dependent resources. They own nothing and are
+  /// never spilled if not set.
+  const ResolvedGraph *resolved = nullptr;
+};
+
+struct BudgetReport {
+  /// Peak of Device memory owned by resources alive at once, in bytes.
+  size_t peakBefore = 0;
+  size_t peakAfter = 0;
+  bool fits = false;
+  /// Number of terminators moved up to the last access of their resource.
+  unsigned hoisted = 0;
+  unsigned rematerialized = 0;
+  unsigned spilled = 0;
+  /// If budget can't be met: action at which most memory is alive and
+  /// resources alive there whose lifetime could not be split.
+  Action *bottleneck = nullptr;
+  std::vector<Allocation *> pinned;
+};
+
+/**
+ * Transforms the graph until peak of Device memory (Host owned buffers do
+ * not count) fits into budget, or no transformation can lower it further.
+ *
+ * At the point of the peak, resources that are alive but not accessed there
+ * have their lifetime split around the gap between two of their accesses:
+ * the resource is terminated right after the access before the gap and a
+ * new one takes its place right before the access after it, filled either
+ * by rematerialization or by spilling:
+ *
+ * 1) Rematerialization repeats Allocation and RealActions that produced
+ * the version read after the gap. Only static Allocations whose RealActions
+ * before the gap read nothing but constants and other resources that are
+ * still alive and not written since at the end of the gap are
+ * rematerialized.
+ * 2) Spilling copies the version into a Host owned buffer before the gap
+ * and back after it with a pair of Transfers. Resources of unknown size
+ * are never spilled.
+ *
+ * Resource accessed after the gap by its Terminator alone just has the
+ * Terminator moved up. Resources read through Compositions or by dynamic
+ * Allocations, resources never terminated and resources created by earlier
+ * splits are never split.
+ *
+ * Resources whose gap spans the whole range of actions over budget around
+ * the peak are preferred, then those that free enough memory on their own,
+ * cheapest first.
+ */
+BudgetReport fitMemoryBudget(Graph &graph, size_t budget,
+                             const BudgetOptions &options = {});
+
+} // namespace rgc
+#endif // RENDERGRAPHCOMPILER_BUDGET_HPP
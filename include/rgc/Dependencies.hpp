@@ -0,0 +1,58 @@
+#ifndef RENDERGRAPHCOMPILER_DEPENDENCIES_HPP
+#define RENDERGRAPHCOMPILER_DEPENDENCIES_HPP
+
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+#include "rgc/Action.hpp"
+#include "rgc/Graph.hpp"
+#include "rgc/ResourceIndex.hpp"
+
+namespace rgc {
+
+/**
+ * @class DependencyGraph
+ *
+ * Execution dependencies between actions of a Graph, tracked per subresource
+ * (mip level and array layer) of every resource.
+ *
+ * Action depends on:
+ * 1) the last writer of every subresource it modifies or reads (RaW, WaW),
+ * 2) every reader of subresource it modifies since the last write (WaR).
+ * Terminator depends on the last writers and readers of all subresources.
+ * The first writer of a SubAllocation also depends on the Terminator of
+ * every resource at overlapping offsets of the same block that is
+ * terminated before it.
+ *
+ * Writes to disjoint subresources of the same image are therefore
+ * independent, even though they form a single use-def chain.
+ *
+ * Dependency graph is a snapshot and must be rebuilt after graph mutation.
+ *
+ */
+class DependencyGraph {
+public:
+  DependencyGraph(const Graph &graph, ResourceIndex &index);
+
+  std::span<Action *const> dependencies(Action *action) const;
+
+  std::span<Action *const> dependents(Action *action) const;
+
+  /**
+   * @return all actions of the graph grouped in waves: every action depends
+   * only on actions from previous waves, so actions of a single wave may be
+   * executed in parallel or batched together.
+   */
+  std::vector<std::vector<Action *>> waves() const;
+
+private:
+  void m_add(Action *action, Action *dependency);
+
+  const Graph &m_graph;
+  std::unordered_map<Action *, std::vector<Action *>> m_dependencies;
+  std::unordered_map<Action *, std::vector<Action *>> m_dependents;
+};
+
+} // namespace rgc
+#endif // RENDERGRAPHCOMPILER_DEPENDENCIES_HPP
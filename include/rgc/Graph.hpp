@@ -1,8 +1,13 @@
 #ifndef RENDERGRAPHCOMPILER_GRAPH_HPP
 #define RENDERGRAPHCOMPILER_GRAPH_HPP
 
+#include <cstdint>
 #include <list>
 #include <memory>
+#include <optional>
+#include <span>
+#include <typeindex>
+#include <vector>
 
 #include "rgc/Action.hpp"
 #include "rgc/Constant.hpp"
@@ -11,11 +16,80 @@
 namespace rgc {
 
 class Action;
+class Graph;
+
+/**
+ * @class StructuralKey
+ *
+ * Flat description of graph structure: order, classes and types of actions,
+ * their operands and own properties (see Action::properties). Key does not
+ * refer to the graph, so it may outlive it. Keys of two graphs are equal
+ * if and only if graphs are structurally equal, except for types and
+ * constants of classes unknown to the library, which are told apart only by
+ * class and hash. External operands (values outside of the graph) are
+ * numbered in order of their first use, so keys tell apart which uses
+ * share an external value.
+ *
+ */
+class StructuralKey {
+public:
+  explicit StructuralKey(const Graph &graph);
+
+  auto hash() const { return m_hash; }
+
+  bool operator==(const StructuralKey &another) const = default;
+
+private:
+  size_t m_hash = 0;
+  std::vector<std::type_index> m_classes;
+  std::vector<std::uint64_t> m_words;
+};
+
+/**
+ * @class GraphObserver
+ *
+ * Interface for objects that want to be notified about mutations of a Graph.
+ * Observers are notified synchronously, right after an action has been
+ * inserted or moved, right before an action is erased and right after one
+ * of action's uses has been replaced (either directly or through
+ * Value::replaceAllUsesWith). Actions inserted together are reported by
+ * a single actionsInserted, after all of them have been linked.
+ *
+ * Observer must be removed from the graph before it is destroyed.
+ *
+ */
+class GraphObserver {
+public:
+  virtual void actionInserted(Action * /*action*/) {}
+
+  virtual void actionsInserted(std::span<Action *const> actions) {
+    for (auto *action : actions)
+      actionInserted(action);
+  }
+
+  virtual void actionErased(Action * /*action*/) {}
+
+  virtual void actionMoved(Action * /*action*/) {}
+
+  virtual void useReplaced(Action * /*user*/, unsigned /*index*/,
+                           Value * /*from*/, Value * /*to*/) {}
+
+  virtual ~GraphObserver() = default;
+};
 
 class Graph : public IList<Action> {
 public:
   virtual ~Graph();
 
+  void addObserver(GraphObserver *observer) {
+    assert(observer && "observer cannot be nullptr");
+    m_observers.push_back(observer);
+  }
+
+  void removeObserver(GraphObserver *observer) {
+    std::erase(m_observers, observer);
+  }
+
   template <class CT, typename... Args>
   requires std::derived_from<CT, Constant>
   auto *getConstant(Args &&...args) {
@@ -27,6 +101,18 @@ public:
   auto *getType(Args &&...args) {
     return m_types.template get<CT>(std::forward<Args>(args)...);
   }
+  /**
+   * @return key describing graph structure (see StructuralKey). Key is
+   * cached until next mutation of the graph, including changes of action
+   * properties.
+   */
+  const StructuralKey &structuralKey() const;
+
+  /**
+   * @return hash of structuralKey().
+   */
+  size_t structuralHash() const { return structuralKey().hash(); }
+
   auto &types() const { return m_types; }
 
   auto &constants() const { return m_constants; }
@@ -35,7 +121,22 @@ public:
 
   auto &constants() { return m_constants; }
 
+protected:
+  void m_inserted(Action *action) override;
+
+  void m_insertedRange(std::span<Action *const> actions) override;
+
+  void m_erasing(Action *action) override;
+
+  void m_moved(Action *action) override;
+
 private:
+  void m_useReplaced(Action *user, unsigned index, Value *from, Value *to);
+
+  friend class Action;
+
+  std::vector<GraphObserver *> m_observers;
+  mutable std::optional<StructuralKey> m_key;
   ConstantPool m_constants;
   TypePool m_types;
 };
@@ -2,24 +2,45 @@
 #define RENDERGRAPHCOMPILER_ILIST_HPP
 
 #include <cassert>
-#include <unordered_map>
+#include <concepts>
+#include <cstddef>
+#include <iterator>
+#include <span>
+#include <type_traits>
 
 namespace rgc {
 
 template <typename T> class IList;
 template <typename T, bool Reverse> class IListIterator;
 
+/**
+ * @class IListNode
+ *
+ * Links of a node of intrusive list. Node knows the list it is linked in,
+ * so membership checks do not need any side table. IListNode is not
+ * polymorphic: list destroys its nodes as T, hence T must have a virtual
+ * destructor if it has subclasses.
+ *
+ */
 template <typename T> class IListNode {
 public:
-  explicit IListNode(IListNode *prev = nullptr, IListNode *next = nullptr)
-      : m_prev{prev}, m_next{next} {}
-  virtual ~IListNode() = default;
+  IListNode() = default;
+  IListNode(const IListNode &) = delete;
+  IListNode &operator=(const IListNode &) = delete;
 
-private:
-  bool m_not_connected() const { return !m_prev && !m_next; }
+  /**
+   * @return list this node is linked in or nullptr.
+   */
+  IList<T> *list() const { return m_list; }
+
+  T *getNextNode() const { return static_cast<T *>(m_next); }
+
+  T *getPrevNode() const { return static_cast<T *>(m_prev); }
 
-  IListNode *m_prev;
-  IListNode *m_next;
+private:
+  IListNode *m_prev = nullptr;
+  IListNode *m_next = nullptr;
+  IList<T> *m_list = nullptr;
   friend class IList<T>;
   friend class IListIterator<T, true>;
   friend class IListIterator<T, false>;
@@ -29,10 +50,10 @@ template <typename T, bool Reverse = false> class IListIterator {
 public:
   explicit IListIterator(IListNode<T> *current) : m_current{current} {}
 
-  using difference_type = void;
+  using difference_type = std::ptrdiff_t;
   using value_type = T *;
   using pointer = void;
-  using reference = void;
+  using reference = T *;
   using iterator_category = std::bidirectional_iterator_tag;
 
   T *operator*() const { return static_cast<T *>(m_current); }
@@ -42,7 +63,7 @@ public:
     return *this;
   }
 
-  auto &operator++(int) {
+  auto operator++(int) {
     auto ret = *this;
     operator++();
     return ret;
@@ -53,7 +74,7 @@ public:
     return *this;
   }
 
-  auto &operator--(int) {
+  auto operator--(int) {
     auto ret = *this;
     operator--();
     return ret;
@@ -69,7 +90,7 @@ private:
 
 template <typename T> using IListForwardIterator = IListIterator<T, false>;
 
-template <typename T> using IListReverseIterator = IListIterator<T, false>;
+template <typename T> using IListReverseIterator = IListIterator<T, true>;
 
 template <typename T> class IList {
 public:
@@ -87,15 +108,117 @@ public:
 
   T *back() const { return static_cast<T *>(m_tail); }
 
-  auto size() const { return m_container.size(); }
+  auto size() const { return m_size; }
+
+  bool empty() const { return m_size == 0; }
 
-  bool empty() const { return m_container.empty(); }
+  bool contains(const IListNode<T> *node) const {
+    return node && node->m_list == this;
+  }
 
   void insertAfter(IListNode<T> *node, IListNode<T> *after) {
+    m_link_after(node, after);
+    m_inserted(static_cast<T *>(node));
+  }
+
+  void insertBefore(IListNode<T> *node, IListNode<T> *before) {
+    m_link_before(node, before);
+    m_inserted(static_cast<T *>(node));
+  }
+
+  /**
+   * Inserts nodes, in order, right before 'before' node or at the end of
+   * the list if 'before' is nullptr. Hook is called once, after all of
+   * them have been linked.
+   */
+  void insertBefore(std::span<T *const> nodes, IListNode<T> *before) {
+    for (auto *node : nodes)
+      m_link_before(node, before);
+    m_insertedRange(nodes);
+  }
+
+  void push_back(IListNode<T> *node) { insertAfter(node, m_tail); }
+
+  void push_front(IListNode<T> *node) { insertBefore(node, m_head); }
+
+  void erase(IListNode<T> *node) {
+    static_assert(std::has_virtual_destructor_v<T> || std::is_final_v<T>,
+                  "T is destroyed through base pointer");
+    assert(contains(node) && "erased node is not registered");
+    m_erasing(static_cast<T *>(node));
+    m_unlink(node);
+    delete static_cast<T *>(node);
+  }
+
+  /**
+   * Moves node of this list right before 'before' node or to the end of
+   * the list if 'before' is nullptr.
+   */
+  void moveBefore(IListNode<T> *node, IListNode<T> *before) {
+    assert(contains(node) && "moved node is not registered");
+    if (node == before)
+      return;
+    m_unlink(node);
+    m_link_before(node, before);
+    m_moved(static_cast<T *>(node));
+  }
+
+  IList() = default;
+  IList(const IList &) = delete;
+  IList &operator=(const IList &) = delete;
+
+  virtual ~IList() {
+    // List owns its nodes
+    while (m_head) {
+      auto *next = m_head->m_next;
+      delete static_cast<T *>(m_head);
+      m_head = next;
+    }
+  }
+
+protected:
+  /// Called right after node has been linked into the list.
+  virtual void m_inserted(T * /*node*/) {}
+
+  /// Called right after a range of nodes has been linked into the list.
+  virtual void m_insertedRange(std::span<T *const> nodes) {
+    for (auto *node : nodes)
+      m_inserted(node);
+  }
+
+  /// Called right before node is unlinked from the list and destroyed.
+  virtual void m_erasing(T * /*node*/) {}
+
+  /// Called right after node has been moved to another position.
+  virtual void m_moved(T * /*node*/) {}
+
+private:
+  void m_unlink(IListNode<T> *node) {
+    auto *next = node->m_next;
+    auto *prev = node->m_prev;
+    if (next) {
+      next->m_prev = prev;
+    }
+    if (prev) {
+      prev->m_next = next;
+    }
+    if (node == m_head) {
+      m_head = next;
+    }
+    if (node == m_tail) {
+      m_tail = prev;
+    }
+    node->m_prev = nullptr;
+    node->m_next = nullptr;
+    node->m_list = nullptr;
+    --m_size;
+  }
+
+  void m_link_after(IListNode<T> *node, IListNode<T> *after) {
     assert(node && "can't emplace null node");
-    assert(node->m_not_connected() && "can insert only unconnected node");
-    assert(!m_container.contains(node) && "double insertion");
-    m_container.emplace(node, node);
+    assert(!node->m_list && "can insert only unconnected node");
+    node->m_list = this;
+    ++m_size;
     if (after == nullptr) {
       // Insert before head
       if (m_head == nullptr) {
@@ -108,7 +231,7 @@ public:
       m_head = node;
       return;
     }
-    assert(m_container.contains(after) && "'after' node is not registered");
+    assert(contains(after) && "'after' node is not registered");
 
     if (after == m_tail)
       m_tail = node;
@@ -116,16 +239,17 @@ public:
       auto *next = after->m_next;
       assert(next && "null next node");
       next->m_prev = node;
+      node->m_next = next;
     }
     after->m_next = node;
     node->m_prev = after;
   }
 
-  void insertBefore(IListNode<T> *node, IListNode<T> *before) {
+  void m_link_before(IListNode<T> *node, IListNode<T> *before) {
     assert(node && "can't emplace null node");
-    assert(node->m_not_connected() && "can insert only unconnected node");
-    assert(!m_container.contains(node) && "double insertion");
-    m_container.emplace(node, node);
+    assert(!node->m_list && "can insert only unconnected node");
+    node->m_list = this;
+    ++m_size;
     if (before == nullptr) {
       // Insert after tail
       if (m_tail == nullptr) {
@@ -138,7 +262,7 @@ public:
       m_tail = node;
       return;
     }
-    assert(m_container.contains(before) && "'before' node is not registered");
+    assert(contains(before) && "'before' node is not registered");
 
     if (before == m_head)
       m_head = node;
@@ -146,38 +270,15 @@ public:
       auto *prev = before->m_prev;
       assert(prev && "null prev node");
       prev->m_next = node;
+      node->m_prev = prev;
     }
     before->m_prev = node;
     node->m_next = before;
   }
 
-  void push_back(IListNode<T> *node) { insertAfter(node, m_tail); }
-
-  void push_front(IListNode<T> *node) { insertBefore(node, m_head); }
-
-  void erase(IListNode<T> *node) {
-    assert(m_container.contains(node) && "erased node is not registered");
-    auto *next = node->m_next;
-    auto *prev = node->m_prev;
-    if (next) {
-      next->m_prev = prev;
-    }
-    if (prev) {
-      prev->m_next = next;
-    }
-    if (node == m_head) {
-      m_head = next;
-    }
-    if (node == m_tail) {
-      m_tail = prev;
-    }
-    m_container.erase(node);
-  }
-
-private:
   IListNode<T> *m_head = nullptr;
   IListNode<T> *m_tail = nullptr;
-  std::unordered_map<IListNode<T> *, std::unique_ptr<IListNode<T>>> m_container;
+  size_t m_size = 0;
 };
 
 } // namespace rgc
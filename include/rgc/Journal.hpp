@@ -0,0 +1,184 @@
+#ifndef RENDERGRAPHCOMPILER_JOURNAL_HPP
+#define RENDERGRAPHCOMPILER_JOURNAL_HPP
+
+#include <cstdint>
+#include <istream>
+#include <memory>
+#include <ostream>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "rgc/Action.hpp"
+#include "rgc/Graph.hpp"
+
+namespace rgc {
+
+/**
+ * @class GraphJournal
+ *
+ * Records construction and mutation of a Graph into a compact binary
+ * stream, which JournalReplay rebuilds the exact graph from.
+ *
+ * Journal starts with a snapshot of actions already in the graph and then
+ * records every insertion, erasure, move and replaced use (including those
+ * made by Value::replaceAllUsesWith) as it happens. Types, constants and
+ * values from outside of the graph are recorded lazily, right before the
+ * first record referring to them, so that interning costs nothing.
+ *
+ * Every record is a tag byte followed by LEB128 encoded integers, values
+ * are referred to by small sequential IDs. Records are accumulated in
+ * memory and written to the stream in blocks.
+ *
+ * Action classes of the library are recorded with all of their state.
+ * Actions of other classes are recorded as their nearest library base
+ * class, types of unknown classes as NullType.
+ *
+ * A value from outside is forgotten as soon as no action of the graph uses
+ * it anymore, so it may be deleted and its address reused by another one.
+ *
+ * Journal must not outlive the graph.
+ *
+ */
+class GraphJournal final : public GraphObserver {
+public:
+  GraphJournal(Graph &graph, std::ostream &os);
+  GraphJournal(const GraphJournal &another) = delete;
+  GraphJournal &operator=(const GraphJournal &another) = delete;
+
+  /**
+   * Writes buffered records to the stream.
+   */
+  void flush();
+
+  /**
+   * @return number of bytes recorded so far.
+   */
+  size_t size() const { return m_written + m_buffer.size(); }
+
+  void actionInserted(Action *action) override;
+
+  void actionsInserted(std::span<Action *const> actions) override;
+
+  void actionErased(Action *action) override;
+
+  void actionMoved(Action *action) override;
+
+  void useReplaced(Action *user, unsigned index, Value *from,
+                   Value *to) override;
+
+  ~GraphJournal() override;
+
+private:
+  void m_insert(Action *action, std::uint64_t next);
+
+  void m_byte(std::uint8_t byte) { m_buffer.push_back(byte); }
+
+  void m_varint(std::uint64_t value);
+
+  std::uint64_t m_type(const Type *type);
+
+  std::uint64_t m_value(Value *value);
+
+  std::uint64_t m_next(const Action *action);
+
+  void m_release(Value *value, const Action *erased);
+
+  void m_flushIfFull();
+
+  Graph &m_graph;
+  std::ostream &m_os;
+  std::string m_buffer;
+  size_t m_written = 0;
+  std::unordered_map<const Type *, std::uint64_t> m_types;
+  std::unordered_map<const Value *, std::uint64_t> m_values;
+  /// Values from outside of the graph among m_values
+  std::unordered_set<const Value *> m_externals;
+  std::uint64_t m_nextValue = 1;
+  std::vector<std::uint64_t> m_operands;
+};
+
+/**
+ * @class JournalReplay
+ *
+ * Rebuilds a graph from journal recorded by GraphJournal, one record at a
+ * time, so that replay of a long journal may be interleaved with any
+ * other work.
+ *
+ * Input is validated: replay stops at the first malformed record, leaving
+ * records replayed so far in the graph, and error() describes the problem.
+ *
+ */
+class JournalReplay {
+public:
+  explicit JournalReplay(std::istream &is);
+  JournalReplay(const JournalReplay &another) = delete;
+  JournalReplay &operator=(const JournalReplay &another) = delete;
+
+  /**
+   * Replays the next record.
+   * @return false if there are no more records or on error.
+   */
+  bool step();
+
+  /**
+   * Replays all remaining records.
+   * @return false on error.
+   */
+  bool run() {
+    while (step())
+      ;
+    return m_error.empty();
+  }
+
+  /**
+   * @return number of records replayed so far.
+   */
+  auto records() const { return m_records; }
+
+  /**
+   * @return description of the first error or empty string.
+   */
+  auto &error() const { return m_error; }
+
+  Graph &graph() { return m_graph; }
+
+private:
+  bool m_fail(std::string_view message);
+
+  std::uint8_t m_byte();
+
+  std::uint64_t m_varint();
+
+  template <typename T> T m_integer();
+
+  template <typename E> E m_enum(std::uint64_t value, E last);
+
+  Type *m_readType();
+
+  Action *m_readAction(std::uint8_t tag);
+
+  Type *m_type(std::uint64_t id);
+
+  Value *m_value(std::uint64_t id);
+
+  Action *m_action(std::uint64_t id);
+
+  bool m_define(std::uint64_t id, Value *value);
+
+  // Stand-ins for values from outside of the graph outlive it
+  std::unordered_map<std::uint64_t, std::unique_ptr<Allocation>> m_externals;
+  Graph m_graph;
+  std::istream &m_is;
+  std::vector<Type *> m_types;
+  /// ID 0 is never defined
+  std::vector<Value *> m_values = {nullptr};
+  size_t m_records = 0;
+  std::string m_error;
+};
+
+} // namespace rgc
+#endif // RENDERGRAPHCOMPILER_JOURNAL_HPP
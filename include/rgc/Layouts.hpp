@@ -0,0 +1,100 @@
+#ifndef RENDERGRAPHCOMPILER_LAYOUTS_HPP
+#define RENDERGRAPHCOMPILER_LAYOUTS_HPP
+
+#include <cstdint>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+#include "rgc/Action.hpp"
+#include "rgc/Graph.hpp"
+
+namespace rgc {
+
+enum class ImageLayout : std::uint8_t {
+  Undefined,
+  General,
+  ColorAttachment,
+  DepthStencilAttachment,
+  ShaderReadOnly,
+  TransferSrc,
+  TransferDst,
+  Present
+};
+
+/**
+ * @struct LayoutTransition
+ *
+ * Transition of subresources of an image, to be executed right before
+ * 'before' action.
+ *
+ */
+struct LayoutTransition {
+  Action *before;
+  Allocation *resource;
+  SubresourceRange range;
+  ImageLayout from;
+  ImageLayout to;
+};
+
+/**
+ * @class LayoutPlan
+ *
+ * Layouts of every image of a graph at each of its accesses, along with
+ * transitions between them.
+ *
+ */
+class LayoutPlan {
+public:
+  /**
+   * @return transitions in graph order.
+   */
+  std::span<const LayoutTransition> transitions() const {
+    return m_transitions;
+  }
+
+  /**
+   * @return layout image is accessed in by action through its use with given
+   * index, or Undefined if that use was not planned (not an image or not a
+   * RealAction). If subresources in range of the use were planned
+   * differently, layout of the first one is returned. Index 2 refers to
+   * read range of RealAction's useDef resource.
+   */
+  ImageLayout layout(const Action *action, unsigned index) const;
+
+private:
+  friend LayoutPlan planLayouts(Graph &graph);
+
+  struct OperandHash {
+    size_t operator()(const std::pair<const Action *, unsigned> &p) const {
+      return std::hash<const Action *>{}(p.first) ^ p.second;
+    }
+  };
+
+  std::vector<LayoutTransition> m_transitions;
+  std::unordered_map<std::pair<const Action *, unsigned>, ImageLayout,
+                     OperandHash>
+      m_layouts;
+};
+
+/**
+ * Plans layouts of every image resource of the graph, per subresource.
+ *
+ * Accesses of a subresource form groups along its use-def chain: every
+ * write is a group of its own, while all RealActions reading the same
+ * version form a single group, since they may be executed in any order and
+ * must agree on a layout. Every usage accepts its optimal layout and
+ * General, which is never optimal for attachments, sampling and transfers.
+ * Layouts of groups are picked by dynamic programming along the chain, so
+ * that the number of transitions plus penalties for accesses in non-optimal
+ * layouts is minimal. Terminator of a ScreenBufferImage resource requires
+ * Present layout. RealAction reading an image through Compositions reads
+ * every version composed in, over all of its subresources.
+ *
+ * Subresources with the same sequence of accesses are planned together and
+ * their transitions are merged into subresource ranges.
+ */
+LayoutPlan planLayouts(Graph &graph);
+
+} // namespace rgc
+#endif // RENDERGRAPHCOMPILER_LAYOUTS_HPP
@@ -0,0 +1,121 @@
+#ifndef RENDERGRAPHCOMPILER_PARTITIONING_HPP
+#define RENDERGRAPHCOMPILER_PARTITIONING_HPP
+
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+#include "rgc/Action.hpp"
+#include "rgc/Graph.hpp"
+#include "rgc/Resolution.hpp"
+
+namespace rgc {
+
+/**
+ * @class DeviceTransfer
+ *
+ * RealAction that copies its 'use' resource from one device into its
+ * useDef resource on another device.
+ *
+ */
+class DeviceTransfer : public RealAction {
+public:
+  DeviceTransfer(Value *destination, Value *source, unsigned from,
+                 unsigned to)
+      : RealAction(destination, source), m_from(from), m_to(to) {}
+
+  auto from() const { return m_from; }
+
+  auto to() const { return m_to; }
+
+  Action *clone(std::span<Value *const> operands) const override {
+    auto *transfer =
+        new DeviceTransfer(operands[0], operands[1], m_from, m_to);
+    transfer->setAccess(access());
+    transfer->setUseAccess(useAccess());
+    return transfer;
+  }
+
+  void properties(std::vector<std::uint64_t> &words) const override {
+    RealAction::properties(words);
+    words.push_back(m_from);
+    words.push_back(m_to);
+  }
+
+private:
+  unsigned m_from;
+  unsigned m_to;
+};
+
+/// Estimated cost of executing an action, in arbitrary time units.
+using ActionCost = std::function<double(const Action *)>;
+
+struct PartitionOptions {
+  unsigned devices = 2;
+  /// Cost of moving one byte between two devices, in ActionCost units.
+  double byteCost = 1e-6;
+  /// Allowed excess of a device's load over the average one.
+  double imbalance = 0.1;
+  /// Maximal number of local refinement passes.
+  unsigned refinementPasses = 8;
+  /// Sizes of screen buffer dependent resources. They weigh nothing if not
+  /// set.
+  const ResolvedGraph *resolved = nullptr;
+};
+
+struct PartitionResult {
+  static constexpr unsigned AnyDevice = ~0u;
+
+  /// Device of every executed action.
+  std::unordered_map<const Action *, unsigned> devices;
+  /// Sum of costs of actions assigned to each device.
+  std::vector<double> loads;
+  /// Transfers inserted at cut edges.
+  std::vector<DeviceTransfer *> transfers;
+  size_t transferredBytes = 0;
+
+  /**
+   * @return device action is executed on or AnyDevice for actions that do
+   * not execute anything (Compositions).
+   */
+  unsigned device(const Action *action) const {
+    auto found = devices.find(action);
+    return found == devices.end() ? AnyDevice : found->second;
+  }
+};
+
+/**
+ * Assigns actions of the graph to devices, so that load is balanced and
+ * cross-device traffic is minimal.
+ *
+ * Unit of assignment is a resource: its Allocation, modifying RealActions
+ * and Terminator share a device. Resources read through Compositions or by
+ * dynamic Allocations are kept on the device of their reader. Assignment
+ * is greedy, heaviest resources first, followed by passes of single
+ * resource moves that reduce traffic or improve balance.
+ *
+ * For every version of a resource read by RealActions on another device a
+ * copy is allocated there and filled by a DeviceTransfer right before the
+ * first of those readers, which then read the copy instead.
+ */
+PartitionResult partitionGraph(Graph &graph, const ActionCost &cost,
+                               const PartitionOptions &options = {});
+
+struct SimulationResult {
+  /// Time at which the last action finishes.
+  double makespan = 0;
+  /// Time each device spent executing actions, transfers excluded.
+  std::vector<double> busy;
+};
+
+/**
+ * Simulates execution of partitioned graph: every device executes its
+ * actions in graph order once their dependencies are done, transfers into
+ * a device are serialized on its own copy queue and take byteCost per byte.
+ */
+SimulationResult simulate(Graph &graph, const PartitionResult &partition,
+                          const ActionCost &cost, double byteCost,
+                          const ResolvedGraph *resolved = nullptr);
+
+} // namespace rgc
+#endif // RENDERGRAPHCOMPILER_PARTITIONING_HPP
@@ -0,0 +1,159 @@
+#ifndef RENDERGRAPHCOMPILER_PIPELINING_HPP
+#define RENDERGRAPHCOMPILER_PIPELINING_HPP
+
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+#include "rgc/Action.hpp"
+#include "rgc/Graph.hpp"
+
+namespace rgc {
+
+/**
+ * @class Import
+ *
+ * Static Allocation that does not create a new resource, but starts this
+ * frame's chain of a persistent resource registered in a FramePipeline.
+ * Persistent resources survive across graphs.
+ *
+ * Import with History access refers to content produced by the previous
+ * frame (e.g. TAA history) and may only be read.
+ *
+ */
+class Import : public Allocation {
+public:
+  enum class Access { Current, History };
+
+  Import(Type *type, unsigned resourceID, Access access = Access::Current)
+      : Allocation(type), m_resourceID(resourceID), m_access(access) {}
+
+  auto resourceID() const { return m_resourceID; }
+
+  auto access() const { return m_access; }
+
+  Action *clone(std::span<Value *const> /*operands*/) const override {
+    return new Import(type(), m_resourceID, m_access);
+  }
+
+  void properties(std::vector<std::uint64_t> &words) const override {
+    words.push_back(m_resourceID);
+    words.push_back(static_cast<std::uint64_t>(m_access));
+  }
+
+private:
+  unsigned m_resourceID;
+  Access m_access;
+};
+
+/**
+ * @struct PhysicalResource
+ *
+ * Backend resource that Allocations of different frames are bound to.
+ *
+ */
+struct PhysicalResource {
+  unsigned id;
+  const Type *type;
+};
+
+struct FramePlan {
+  size_t frame;
+  /// Physical resource bound to every Allocation that owns memory.
+  std::unordered_map<const Allocation *, PhysicalResource> bindings;
+  /// Physical resources that must be created before executing the frame.
+  std::vector<PhysicalResource> created;
+  /// Physical resources no longer used by any frame in flight. Type of
+  /// resources whose type class is unknown to the library is nullptr.
+  std::vector<PhysicalResource> released;
+};
+
+/**
+ * @class FramePipeline
+ *
+ * Binds Allocations of consecutive frame graphs to physical resources, so
+ * that CPU can record up to framesInFlight frames ahead of GPU.
+ *
+ * Persistent resources are ring buffered only where a cross-frame hazard
+ * exists:
+ * 1) Host owned resource written by a frame needs a copy per frame in
+ * flight, as CPU writes it while previous frames may still be read by GPU.
+ * 2) Resource written by a frame and read as History by the next one needs
+ * at least two copies (ping-pong).
+ * 3) Any other persistent resource has a single copy, since device work of
+ * consecutive frames is ordered on GPU anyway.
+ * Ring of a persistent resource only grows, as new usage patterns are met.
+ * A frame writing the resource writes the copy after the one written last,
+ * and History always refers to the copy written last, even across growth
+ * of the ring or frames not touching the resource.
+ *
+ * Transient allocations (those terminated within a frame) reuse physical
+ * resources of matching type from previous frames: a Device owned one is
+ * reused in the next frame, a Host owned one once its frame is no longer in
+ * flight. Physical resources idle for more than maxIdleFrames, and at least
+ * until no frame in flight uses them, are released. Allocations that are
+ * not terminated or whose type is unknown to the library get a physical
+ * resource of their own, released once their frame is no longer in flight.
+ * Screen buffers and SubAllocations do not own memory and are not bound.
+ *
+ */
+class FramePipeline {
+public:
+  explicit FramePipeline(unsigned framesInFlight, unsigned maxIdleFrames = 8);
+
+  /**
+   * Registers persistent resource of given type.
+   * @return ID of the resource to be used by Imports.
+   */
+  template <class T, typename... Args>
+  requires std::derived_from<T, Type>
+  unsigned addPersistent(Args &&...args) {
+    auto &persistent = m_persistent.emplace_back();
+    persistent.type = m_types.template get<T>(std::forward<Args>(args)...);
+    return m_persistent.size() - 1;
+  }
+
+  /**
+   * @return number of copies of the persistent resource in its ring.
+   */
+  auto copies(unsigned resourceID) const {
+    return m_persistent.at(resourceID).copies.size();
+  }
+
+  auto framesInFlight() const { return m_framesInFlight; }
+
+  /**
+   * Binds Allocations of the next frame's graph.
+   */
+  FramePlan beginFrame(Graph &graph);
+
+private:
+  struct Persistent {
+    Type *type = nullptr;
+    bool hostWritten = false;
+    bool history = false;
+    std::vector<PhysicalResource> copies;
+    /// Copy written by the last frame that wrote the resource
+    std::optional<size_t> written;
+  };
+
+  struct Slot {
+    PhysicalResource resource;
+    size_t lastUse;
+  };
+
+  PhysicalResource m_create(const Type *type, FramePlan &plan);
+
+  unsigned m_framesInFlight;
+  unsigned m_maxIdleFrames;
+  size_t m_frame = 0;
+  unsigned m_nextID = 0;
+  TypePool m_types;
+  std::vector<Persistent> m_persistent;
+  std::unordered_map<const Type *, std::vector<Slot>> m_transients;
+  /// Resources bound to a single frame, released once it is not in flight
+  std::vector<Slot> m_retired;
+};
+
+} // namespace rgc
+#endif // RENDERGRAPHCOMPILER_PIPELINING_HPP
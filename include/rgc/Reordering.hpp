@@ -0,0 +1,56 @@
+#ifndef RENDERGRAPHCOMPILER_REORDERING_HPP
+#define RENDERGRAPHCOMPILER_REORDERING_HPP
+
+#include "rgc/Graph.hpp"
+#include "rgc/Resolution.hpp"
+
+namespace rgc {
+
+struct ReorderOptions {
+  /// How many dependency waves the scheduler may run ahead of the earliest
+  /// ready action to lower memory usage. 0 keeps actions in wave order, so
+  /// that actions which could run in parallel stay adjacent; larger values
+  /// trade that parallelism for lower peak memory.
+  unsigned maxWaveSkew = ~0u;
+  /// Sizes of screen buffer dependent resources. They own nothing if not
+  /// set.
+  const ResolvedGraph *resolved = nullptr;
+};
+
+struct ReorderReport {
+  /// Peak memory of resources alive at once, in bytes.
+  size_t peakBefore = 0;
+  size_t peakAfter = 0;
+};
+
+/**
+ * @return bytes of memory owned by resource: SubAllocations, Imports and
+ * screen buffers do not own any. Screen buffer dependent resources are
+ * sized by resolved view, if given.
+ */
+size_t ownedBytes(const Allocation *allocation,
+                  const ResolvedGraph *resolved = nullptr);
+
+/**
+ * @return peak amount of memory owned by resources alive at once, when
+ * actions are executed in graph order. Resource is alive from its
+ * Allocation up to its Terminator, or up to the end of the graph if it is
+ * never terminated.
+ */
+size_t peakMemory(const Graph &graph, const ResolvedGraph *resolved = nullptr);
+
+/**
+ * Reorders actions of the graph to reduce peak memory, respecting use-def
+ * and execution dependencies (see DependencyGraph).
+ *
+ * Actions are list scheduled: among ready actions Terminators go first,
+ * then actions accessing the same resource as the previously scheduled
+ * one, then any other non-Allocation, and Allocations are deferred until
+ * nothing else is ready, smallest first. Other ties keep the original
+ * order.
+ */
+ReorderReport reorderForMemory(Graph &graph,
+                               const ReorderOptions &options = {});
+
+} // namespace rgc
+#endif // RENDERGRAPHCOMPILER_REORDERING_HPP
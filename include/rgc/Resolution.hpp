@@ -0,0 +1,176 @@
+#ifndef RENDERGRAPHCOMPILER_RESOLUTION_HPP
+#define RENDERGRAPHCOMPILER_RESOLUTION_HPP
+
+#include <algorithm>
+#include <array>
+#include <functional>
+#include <map>
+#include <unordered_map>
+#include <vector>
+
+#include "rgc/Graph.hpp"
+#include "rgc/Types.hpp"
+
+namespace rgc {
+
+/**
+ * @class ResolutionSet
+ *
+ * Concrete extents of screen buffers, keyed by swap chain ID.
+ *
+ */
+class ResolutionSet {
+public:
+  void set(unsigned swapChainID, size_t width, size_t height) {
+    m_extents[swapChainID] = {width, height, 1u};
+  }
+
+  /**
+   * @return extents of swap chain images or nullptr if they are not set.
+   */
+  const std::array<size_t, 3> *extents(unsigned swapChainID) const {
+    auto found = m_extents.find(swapChainID);
+    return found == m_extents.end() ? nullptr : &found->second;
+  }
+
+  bool operator==(const ResolutionSet &another) const = default;
+
+private:
+  std::map<unsigned, std::array<size_t, 3>> m_extents;
+};
+
+/**
+ * @class ResolvedGraph
+ *
+ * View of a Graph in which ScreenBuffer and TiedToScreenBuffer images have
+ * static extents taken from a ResolutionSet. Resolved types are owned by the
+ * view and never leak into graph's TypePool. Types that do not depend on
+ * screen buffers resolve to themselves. Passes weighing resources by size
+ * (partitionGraph, reorderForMemory, fitMemoryBudget) take a view to size
+ * screen buffer dependent ones.
+ *
+ * View must not outlive the graph.
+ *
+ */
+class ResolvedGraph {
+public:
+  ResolvedGraph(const Graph &graph, const ResolutionSet &resolutions);
+
+  Type *resolve(Type *type) const {
+    auto found = m_resolved.find(type);
+    return found == m_resolved.end() ? type : found->second;
+  }
+
+  Type *type(const Value *value) const { return resolve(value->type()); }
+
+  /**
+   * @return size of a resource of given type in bytes or 0 if it is unknown.
+   */
+  size_t byteSize(const Type *type) const {
+    auto found = m_resolved.find(type);
+    return rgc::byteSize(found == m_resolved.end() ? type : found->second);
+  }
+
+  /**
+   * @return size of value's resource in bytes or 0 if it is unknown.
+   */
+  size_t byteSize(const Value *value) const {
+    return byteSize(value->type());
+  }
+
+  /**
+   * @return true if every screen buffer dependent type has been resolved.
+   */
+  bool complete() const { return m_complete; }
+
+  auto &graph() const { return m_graph; }
+
+private:
+  const Graph &m_graph;
+  TypePool m_types;
+  std::unordered_map<const Type *, Type *> m_resolved;
+  bool m_complete = true;
+};
+
+/**
+ * @return size of a resource of given type in bytes, with screen buffer
+ * dependent types resolved if a view is given, or 0 if it is unknown.
+ */
+inline size_t byteSize(const Type *type, const ResolvedGraph *resolved) {
+  return resolved ? resolved->byteSize(type) : byteSize(type);
+}
+
+/**
+ * @class SpecializationCache
+ *
+ * Cache of compilation results keyed by (graph StructuralKey,
+ * ResolutionSet). Keys are compared in full once their hashes match, so
+ * results are never shared by graphs whose hashes collide. Compiler is
+ * invoked only on a miss, so switching between a handful of resolutions
+ * never recompiles in steady state. Least recently used entry is evicted
+ * once capacity is reached.
+ *
+ * Compiled result must not reference the ResolvedGraph it was produced from.
+ *
+ */
+template <typename Compiled> class SpecializationCache {
+public:
+  using Compiler = std::function<Compiled(const ResolvedGraph &)>;
+
+  explicit SpecializationCache(Compiler compiler, size_t capacity = 8)
+      : m_compiler(std::move(compiler)), m_capacity(capacity) {
+    assert(m_capacity != 0 && "capacity can't be zero");
+    m_entries.reserve(m_capacity);
+  }
+
+  /**
+   * @return compiled output for graph specialized with resolutions.
+   * Reference stays valid until next call.
+   */
+  const Compiled &get(const Graph &graph, const ResolutionSet &resolutions) {
+    auto &key = graph.structuralKey();
+    ++m_clock;
+    for (auto &entry : m_entries) {
+      if (entry.key.hash() == key.hash() && entry.resolutions == resolutions &&
+          entry.key == key) {
+        entry.lastUse = m_clock;
+        ++m_hits;
+        return entry.compiled;
+      }
+    }
+    ++m_misses;
+    auto resolved = ResolvedGraph{graph, resolutions};
+    auto entry = Entry{key, resolutions, m_compiler(resolved), m_clock};
+    if (m_entries.size() < m_capacity) {
+      m_entries.push_back(std::move(entry));
+      return m_entries.back().compiled;
+    }
+    auto lru = std::ranges::min_element(m_entries, {}, &Entry::lastUse);
+    *lru = std::move(entry);
+    return lru->compiled;
+  }
+
+  auto hits() const { return m_hits; }
+
+  auto misses() const { return m_misses; }
+
+  void clear() { m_entries.clear(); }
+
+private:
+  struct Entry {
+    StructuralKey key;
+    ResolutionSet resolutions;
+    Compiled compiled;
+    size_t lastUse;
+  };
+
+  Compiler m_compiler;
+  size_t m_capacity;
+  size_t m_clock = 0;
+  size_t m_hits = 0;
+  size_t m_misses = 0;
+  std::vector<Entry> m_entries;
+};
+
+} // namespace rgc
+#endif // RENDERGRAPHCOMPILER_RESOLUTION_HPP
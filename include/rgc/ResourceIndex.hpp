@@ -0,0 +1,91 @@
+#ifndef RENDERGRAPHCOMPILER_RESOURCEINDEX_HPP
+#define RENDERGRAPHCOMPILER_RESOURCEINDEX_HPP
+
+#include <ranges>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+#include "rgc/Action.hpp"
+#include "rgc/Graph.hpp"
+
+namespace rgc {
+
+/**
+ * @class ResourceIndex
+ *
+ * Index from each resource (root Allocation) of a Graph to the actions that
+ * touch it:
+ *
+ * 1) chain - RealActions that modify the resource, in use-def order.
+ * 2) terminator - Terminator of the resource, if any.
+ * 3) readers - actions that only read some version of the resource. That is
+ * RealActions using a version as their 'use' value, dynamic Allocations and
+ * any action reading the version through (possibly nested) Compositions.
+ *
+ * Only actions inserted in the graph are indexed. Index observes the graph
+ * and is kept up to date incrementally: appending to the end of a chain is
+ * handled in place, any other mutation marks affected resources as stale
+ * and they are recomputed on next query by walking only their own chain.
+ *
+ * Index must not outlive the graph.
+ *
+ */
+class ResourceIndex final : public GraphObserver {
+public:
+  explicit ResourceIndex(Graph &graph);
+  ResourceIndex(const ResourceIndex &another) = delete;
+  ResourceIndex &operator=(const ResourceIndex &another) = delete;
+
+  /**
+   * @return resource that value is a version of, or nullptr if value is not
+   * a part of any resource chain (Compositions, Constants).
+   */
+  Allocation *resourceOf(Value *value);
+
+  std::span<RealAction *const> chain(Allocation *resource);
+
+  Terminator *terminator(Allocation *resource);
+
+  std::span<Action *const> readers(Allocation *resource);
+
+  /**
+   * @return last version of the resource: last RealAction in its chain
+   * or resource itself if it was never modified.
+   */
+  Value *lastVersion(Allocation *resource);
+
+  auto resources() const { return std::views::keys(m_resources); }
+
+  void actionInserted(Action *action) override;
+
+  void actionErased(Action *action) override;
+
+  void useReplaced(Action *user, unsigned index, Value *from,
+                   Value *to) override;
+
+  ~ResourceIndex() override;
+
+private:
+  struct Record {
+    std::vector<RealAction *> chain;
+    std::vector<Action *> readers;
+    Terminator *terminator = nullptr;
+    bool stale = false;
+  };
+
+  Record *m_record(Allocation *resource);
+
+  void m_rebuild(Allocation *resource, Record &record);
+
+  void m_touch(Value *value);
+
+  void m_read(Action *reader, Value *value);
+
+  Graph &m_graph;
+  std::unordered_map<Allocation *, Record> m_resources;
+  std::unordered_map<Action *, Allocation *> m_owners;
+};
+
+} // namespace rgc
+#endif // RENDERGRAPHCOMPILER_RESOURCEINDEX_HPP
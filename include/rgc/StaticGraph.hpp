@@ -0,0 +1,376 @@
+#ifndef RENDERGRAPHCOMPILER_STATICGRAPH_HPP
+#define RENDERGRAPHCOMPILER_STATICGRAPH_HPP
+
+#include <algorithm>
+#include <array>
+#include <span>
+#include <vector>
+
+#include "rgc/Action.hpp"
+#include "rgc/Constant.hpp"
+#include "rgc/Graph.hpp"
+#include "rgc/Suballocation.hpp"
+#include "rgc/Types.hpp"
+
+namespace rgc {
+
+/**
+ * @struct StaticType
+ *
+ * Compile time description of an allocated Image or a Buffer type.
+ *
+ */
+struct StaticType {
+  enum class Kind { Image, Buffer };
+
+  Kind kind = Kind::Buffer;
+  ImageType::PixelFormat pixelFormat = ImageType::PixelFormat::Auto;
+  ImageType::ExtentType extentType = ImageType::ExtentType::T2D;
+  unsigned mipLevels = 1;
+  unsigned arrayLayers = 1;
+  std::array<size_t, 3> extents{};
+  ScalarType::OwnerType owner = ScalarType::OwnerType::Device;
+  size_t elementSize = 1;
+  size_t elementCount = 0;
+
+  static constexpr StaticType image(ImageType::PixelFormat pf,
+                                    ImageType::ExtentType et,
+                                    std::array<size_t, 3> extents,
+                                    unsigned mipLevels = 1,
+                                    unsigned arrayLayers = 1) {
+    auto type = StaticType{Kind::Image, pf, et, mipLevels, arrayLayers};
+    type.extents = extents;
+    return type;
+  }
+
+  static constexpr StaticType buffer(ScalarType::OwnerType owner, size_t es,
+                                     size_t ec) {
+    auto type = StaticType{};
+    type.owner = owner;
+    type.elementSize = es;
+    type.elementCount = ec;
+    return type;
+  }
+
+  constexpr size_t byteSize() const {
+    if (kind == Kind::Image)
+      return ImageType::byteSize(pixelFormat, mipLevels, extents, arrayLayers);
+    return elementSize * elementCount;
+  }
+
+  /**
+   * @return runtime type interned in graph's TypePool.
+   */
+  Type *intern(Graph &graph) const {
+    if (kind == Kind::Image)
+      return graph.getType<ImageType>(ImageType::ImageKind::Allocated,
+                                      pixelFormat, extentType, mipLevels,
+                                      extents, arrayLayers);
+    return graph.getType<BufferType>(owner, elementSize, elementCount);
+  }
+
+  bool operator==(const StaticType &another) const = default;
+};
+
+/**
+ * @struct StaticNode
+ *
+ * Compile time counterpart of an Action. Input node stands for a runtime
+ * value that is provided when static graph is spliced into a Graph.
+ *
+ */
+struct StaticNode {
+  enum class Kind { Input, Allocation, RealAction, Terminator };
+  static constexpr unsigned None = ~0u;
+
+  Kind kind = Kind::Input;
+  unsigned type = None;
+  unsigned useDef = None;
+  unsigned use = None;
+  SubresourceRange range{};
+  SubresourceRange useRange{};
+};
+
+/**
+ * @class StaticGraph
+ *
+ * Builder of a graph that is fully known at compile time. Every method is
+ * constexpr, so the graph is meant to be declared as
+ *
+ *   constexpr auto pipeline = [] {
+ *     auto graph = StaticGraph<8>{};
+ *     auto image = graph.allocate(StaticType::image(...));
+ *     graph.terminate(graph.modify(image));
+ *     return graph;
+ *   }();
+ *
+ * and compiled with compileStatic(), which evaluates validation, scheduling
+ * and memory planning at compile time as well.
+ *
+ */
+template <size_t MaxNodes, size_t MaxTypes = MaxNodes> class StaticGraph {
+public:
+  constexpr unsigned input(StaticType type) {
+    return m_push({StaticNode::Kind::Input, m_type(type)});
+  }
+
+  constexpr unsigned allocate(StaticType type) {
+    return m_push({StaticNode::Kind::Allocation, m_type(type)});
+  }
+
+  constexpr unsigned modify(unsigned useDef, unsigned use = StaticNode::None,
+                            SubresourceRange range = {},
+                            SubresourceRange useRange = {}) {
+    assert(useDef < m_nodeCount && "invalid useDef node");
+    return m_push({StaticNode::Kind::RealAction, m_nodes[useDef].type, useDef,
+                   use, range, useRange});
+  }
+
+  constexpr unsigned terminate(unsigned value) {
+    assert(value < m_nodeCount && "invalid terminated node");
+    return m_push({StaticNode::Kind::Terminator, StaticNode::None, value});
+  }
+
+  constexpr std::span<const StaticNode> nodes() const {
+    return {m_nodes.data(), m_nodeCount};
+  }
+
+  constexpr std::span<const StaticType> types() const {
+    return {m_types.data(), m_typeCount};
+  }
+
+private:
+  constexpr unsigned m_type(StaticType type) {
+    for (unsigned i = 0; i < m_typeCount; ++i)
+      if (m_types[i] == type)
+        return i;
+    assert(m_typeCount < MaxTypes && "too many types");
+    m_types[m_typeCount] = type;
+    return m_typeCount++;
+  }
+
+  constexpr unsigned m_push(StaticNode node) {
+    assert(m_nodeCount < MaxNodes && "too many nodes");
+    m_nodes[m_nodeCount] = node;
+    return m_nodeCount++;
+  }
+
+  std::array<StaticNode, MaxNodes> m_nodes{};
+  size_t m_nodeCount = 0;
+  std::array<StaticType, MaxTypes> m_types{};
+  size_t m_typeCount = 0;
+};
+
+enum class StaticGraphError {
+  None,
+  /// Operand refers to a node that does not precede user, to a Terminator
+  /// or RealAction reads the value it modifies.
+  InvalidOperand,
+  /// Version is modified or terminated more than once.
+  ForkedChain,
+  /// Version is read after it has been modified or terminated.
+  StaleRead,
+  /// Allocation is never terminated.
+  NotTerminated,
+};
+
+/**
+ * @struct CompiledStaticGraph
+ *
+ * Static tables produced from a StaticGraph at compile time:
+ * 1) resource - root Input or Allocation node of every node.
+ * 2) wave - scheduling level; nodes of one wave are independent.
+ * 3) offset - offset of every Allocation in a single heap of heapSize
+ * bytes, aligned to alignment. Allocations whose lifetimes (in waves) do
+ * not overlap alias.
+ *
+ */
+template <size_t MaxNodes, size_t MaxTypes> struct CompiledStaticGraph {
+  StaticGraph<MaxNodes, MaxTypes> graph{};
+  StaticGraphError error = StaticGraphError::None;
+  unsigned errorNode = StaticNode::None;
+  std::array<unsigned, MaxNodes> resource{};
+  std::array<unsigned, MaxNodes> wave{};
+  std::array<size_t, MaxNodes> offset{};
+  unsigned waveCount = 0;
+  size_t heapSize = 0;
+  size_t alignment = 1;
+
+  constexpr bool valid() const { return error == StaticGraphError::None; }
+};
+
+template <size_t Alignment = 256u, size_t MaxNodes, size_t MaxTypes>
+constexpr CompiledStaticGraph<MaxNodes, MaxTypes>
+compileStatic(const StaticGraph<MaxNodes, MaxTypes> &graph) {
+  using Kind = StaticNode::Kind;
+  constexpr auto None = StaticNode::None;
+  auto compiled = CompiledStaticGraph<MaxNodes, MaxTypes>{graph};
+  compiled.alignment = Alignment;
+  auto nodes = graph.nodes();
+  auto fail = [&](StaticGraphError error, unsigned node) {
+    compiled.error = error;
+    compiled.errorNode = node;
+    return compiled;
+  };
+
+  // Validation and scheduling in a single sweep
+  std::array<bool, MaxNodes> consumed{};
+  std::array<unsigned, MaxNodes> lastVersion{};
+  std::array<unsigned, MaxNodes> terminator{};
+  std::array<unsigned, MaxNodes> readersWave{};
+  std::array<unsigned, MaxNodes> firstWave{};
+  for (unsigned i = 0; i < nodes.size(); ++i) {
+    terminator[i] = None;
+    auto &node = nodes[i];
+    auto valid = [&](unsigned operand) {
+      return operand < i && nodes[operand].kind != Kind::Terminator;
+    };
+    auto stale = [&](unsigned operand) {
+      return lastVersion[compiled.resource[operand]] != operand;
+    };
+    switch (node.kind) {
+    case Kind::Input:
+    case Kind::Allocation:
+      compiled.resource[i] = i;
+      lastVersion[i] = i;
+      compiled.wave[i] = 0;
+      break;
+    case Kind::RealAction:
+    case Kind::Terminator: {
+      if (!valid(node.useDef))
+        return fail(StaticGraphError::InvalidOperand, i);
+      if (consumed[node.useDef])
+        return fail(StaticGraphError::ForkedChain, i);
+      consumed[node.useDef] = true;
+      auto root = compiled.resource[node.useDef];
+      compiled.resource[i] = root;
+      unsigned wave = std::max(compiled.wave[node.useDef], readersWave[root]);
+      if (node.kind == Kind::RealAction && node.use != None) {
+        if (!valid(node.use) || node.use == node.useDef)
+          return fail(StaticGraphError::InvalidOperand, i);
+        if (stale(node.use))
+          return fail(StaticGraphError::StaleRead, i);
+        wave = std::max(wave, compiled.wave[node.use]);
+      }
+      compiled.wave[i] = wave + 1;
+      if (node.useDef == root)
+        firstWave[root] = compiled.wave[i];
+      readersWave[root] = 0;
+      if (node.kind == Kind::RealAction) {
+        lastVersion[root] = i;
+        if (node.use != None) {
+          auto &readers = readersWave[compiled.resource[node.use]];
+          readers = std::max(readers, compiled.wave[i]);
+        }
+      } else {
+        lastVersion[root] = None;
+        terminator[root] = i;
+      }
+      break;
+    }
+    }
+    compiled.waveCount = std::max(compiled.waveCount, compiled.wave[i] + 1);
+  }
+
+  // Memory planning: first fit of allocations into a single heap
+  auto alignUp = [](size_t value) {
+    return (value + Alignment - 1u) / Alignment * Alignment;
+  };
+  for (unsigned i = 0; i < nodes.size(); ++i) {
+    if (nodes[i].kind != Kind::Allocation)
+      continue;
+    if (terminator[i] == None)
+      return fail(StaticGraphError::NotTerminated, i);
+    auto size = alignUp(graph.types()[nodes[i].type].byteSize());
+    // Memory is needed from the first modification of the resource
+    auto begin = firstWave[i];
+    auto end = compiled.wave[terminator[i]];
+    size_t offset = 0;
+    for (bool moved = true; moved;) {
+      moved = false;
+      for (unsigned j = 0; j < i; ++j) {
+        if (nodes[j].kind != Kind::Allocation)
+          continue;
+        auto otherSize = alignUp(graph.types()[nodes[j].type].byteSize());
+        auto overlapsInTime =
+            firstWave[j] <= end && begin <= compiled.wave[terminator[j]];
+        auto overlapsInMemory = compiled.offset[j] < offset + size &&
+                                offset < compiled.offset[j] + otherSize;
+        if (overlapsInTime && overlapsInMemory) {
+          offset = compiled.offset[j] + otherSize;
+          moved = true;
+        }
+      }
+    }
+    compiled.offset[i] = offset;
+    compiled.heapSize = std::max(compiled.heapSize, offset + size);
+  }
+  return compiled;
+}
+
+/**
+ * Splices compiled static graph into a runtime Graph: every type is
+ * interned once and every node becomes an action appended to the graph.
+ * Input nodes are bound to inputs in order of their declaration.
+ *
+ * Memory plan is kept: Allocation nodes become SubAllocations of a single
+ * Device heap buffer at their compiled offsets. Heap is allocated before
+ * and terminated after all nodes, and DependencyGraph orders resources
+ * that alias in it.
+ *
+ * @return runtime values of all nodes, indexed by node.
+ */
+template <size_t MaxNodes, size_t MaxTypes>
+std::vector<Value *>
+splice(Graph &graph, const CompiledStaticGraph<MaxNodes, MaxTypes> &compiled,
+       std::span<Value *const> inputs = {}) {
+  assert(compiled.valid() && "can't splice invalid static graph");
+  auto staticTypes = compiled.graph.types();
+  std::array<Type *, MaxTypes> types{};
+  for (size_t i = 0; i < staticTypes.size(); ++i)
+    types[i] = staticTypes[i].intern(graph);
+
+  auto *null = graph.getConstant<NullConstant>(graph.types());
+  auto nodes = compiled.graph.nodes();
+  Allocation *heap = nullptr;
+  if (compiled.heapSize != 0) {
+    heap = new Allocation{graph.getType<BufferType>(
+        ScalarType::OwnerType::Device, compiled.alignment,
+        compiled.heapSize / compiled.alignment)};
+    graph.push_back(heap);
+  }
+  std::vector<Value *> values(nodes.size());
+  auto nextInput = inputs.begin();
+  for (size_t i = 0; i < nodes.size(); ++i) {
+    auto &node = nodes[i];
+    Action *action = nullptr;
+    switch (node.kind) {
+    case StaticNode::Kind::Input:
+      assert(nextInput != inputs.end() && "not enough inputs");
+      assert((*nextInput)->type()->equal(types[node.type]) &&
+             "input type mismatch");
+      values[i] = *nextInput++;
+      continue;
+    case StaticNode::Kind::Allocation:
+      action = new SubAllocation{types[node.type], heap, compiled.offset[i]};
+      break;
+    case StaticNode::Kind::RealAction:
+      action = new RealAction{
+          values[node.useDef],
+          node.use == StaticNode::None ? null : values[node.use], node.range,
+          node.useRange};
+      break;
+    case StaticNode::Kind::Terminator:
+      action = new Terminator{graph.types(), values[node.useDef]};
+      break;
+    }
+    graph.push_back(action);
+    values[i] = action;
+  }
+  if (heap)
+    graph.push_back(new Terminator{graph.types(), heap});
+  return values;
+}
+
+} // namespace rgc
+#endif // RENDERGRAPHCOMPILER_STATICGRAPH_HPP
@@ -0,0 +1,74 @@
+#ifndef RENDERGRAPHCOMPILER_SUBALLOCATION_HPP
+#define RENDERGRAPHCOMPILER_SUBALLOCATION_HPP
+
+#include <vector>
+
+#include "rgc/Action.hpp"
+#include "rgc/Graph.hpp"
+
+namespace rgc {
+
+/**
+ * @class SubAllocation
+ *
+ * Dynamic Allocation of a resource that is placed at fixed offset inside
+ * another, larger, buffer resource (block). SubAllocation does not allocate
+ * memory by itself: it is a view into its block, and block must outlive
+ * every resource suballocated from it. Resources at overlapping offsets
+ * alias, so their lifetimes must not overlap.
+ *
+ */
+class SubAllocation : public Allocation {
+public:
+  SubAllocation(Type *type, Value *block, size_t offset)
+      : Allocation(type, block), m_offset(offset) {}
+
+  auto *block() const { return uses()[0]; }
+
+  auto offset() const { return m_offset; }
+
+  Action *clone(std::span<Value *const> operands) const override {
+    return new SubAllocation(type(), operands[0], m_offset);
+  }
+
+  void properties(std::vector<std::uint64_t> &words) const override {
+    words.push_back(m_offset);
+  }
+
+private:
+  size_t m_offset;
+};
+
+struct SuballocationOptions {
+  /// Buffers larger than this keep their own allocation.
+  size_t maxBufferSize = 64u * 1024u;
+  /// Preferred size of a block. Blocks are never larger than that unless
+  /// a single buffer does not fit.
+  size_t blockSize = 4u * 1024u * 1024u;
+  /// Buffer is aligned to the least common multiple of its element size and
+  /// minAlignment. Buffers needing more than maxAlignment aren't shared and
+  /// neither are buffers whose alignments combine to more than that.
+  size_t minAlignment = 16u;
+  size_t maxAlignment = 256u;
+};
+
+struct SuballocationResult {
+  /// Allocations of newly created blocks.
+  std::vector<Allocation *> blocks;
+  /// Number of buffers turned into SubAllocations.
+  size_t suballocated = 0;
+};
+
+/**
+ * Groups small static BufferType allocations with the same OwnerType into
+ * shared blocks. Every such Allocation is replaced with a SubAllocation at
+ * an offset aligned to its element size, block is allocated before the
+ * first and terminated after the last action touching its buffers.
+ * Element size of a block is the least common multiple of alignments of its
+ * buffers.
+ */
+SuballocationResult suballocateBuffers(Graph &graph,
+                                       const SuballocationOptions &options = {});
+
+} // namespace rgc
+#endif // RENDERGRAPHCOMPILER_SUBALLOCATION_HPP
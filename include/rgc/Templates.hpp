@@ -0,0 +1,125 @@
+#ifndef RENDERGRAPHCOMPILER_TEMPLATES_HPP
+#define RENDERGRAPHCOMPILER_TEMPLATES_HPP
+
+#include <memory>
+#include <span>
+#include <type_traits>
+#include <typeindex>
+#include <unordered_map>
+#include <vector>
+
+#include "rgc/Action.hpp"
+#include "rgc/Graph.hpp"
+
+namespace rgc {
+
+class SubgraphTemplate;
+
+/**
+ * @class SubgraphInstance
+ *
+ * Actions created by a single instantiation of a SubgraphTemplate. Action
+ * at index i is a clone of template's prototype at index i.
+ *
+ */
+class SubgraphInstance {
+public:
+  auto &source() const { return *m_source; }
+
+  std::span<Action *const> actions() const { return m_actions; }
+
+  Action *operator[](size_t i) const { return m_actions[i]; }
+
+private:
+  friend class SubgraphTemplate;
+
+  const SubgraphTemplate *m_source;
+  std::vector<Action *> m_actions;
+};
+
+/**
+ * @class SubgraphTemplate
+ *
+ * Pattern of actions captured once and instantiated many times, e.g. a
+ * pass repeated per shadow cascade, light or view.
+ *
+ * Operands of captured actions that are listed as parameters are replaced
+ * with arguments of each instantiation. Any other operand from outside of
+ * the captured actions is shared by all instances. Instances share
+ * interned types with the captured actions, so the graph actions were
+ * captured from must outlive them.
+ *
+ * Template keeps its prototypes in a graph of its own (body), in which
+ * every value from outside is replaced with a placeholder Allocation of
+ * the same type. Analyses may be run on the body once and their results,
+ * indexed by prototype, reused for every instance.
+ *
+ */
+class SubgraphTemplate {
+public:
+  /**
+   * Captures actions, which must be given in execution order. Captured
+   * actions are left intact.
+   */
+  SubgraphTemplate(std::span<Action *const> actions,
+                   std::span<Value *const> parameters);
+  SubgraphTemplate(const SubgraphTemplate &another) = delete;
+  SubgraphTemplate &operator=(const SubgraphTemplate &another) = delete;
+
+  auto parameterCount() const { return m_parameterCount; }
+
+  std::span<Action *const> prototypes() const { return m_prototypes; }
+
+  /**
+   * @return index of prototype or -1 if action is not a prototype.
+   */
+  ptrdiff_t indexOf(const Action *prototype) const;
+
+  Graph &body() { return m_body; }
+
+  /**
+   * Clones every prototype into graph, right before 'before' action or at
+   * the end of the graph if it is nullptr. Operands are remapped in one pass
+   * through a precomputed table, no type or constant lookup is made.
+   * Clones are inserted together: observers get a single actionsInserted.
+   */
+  SubgraphInstance instantiate(Graph &graph,
+                               std::span<Value *const> arguments,
+                               Action *before = nullptr) const;
+
+  /**
+   * @return result of analysis over template body. It is computed by
+   * compute(body()) on first request and cached by types of compute and R,
+   * so that every instance reuses it. Analyses sharing result type but
+   * computed by functions of different types are cached apart.
+   */
+  template <typename R, typename F> const R &analysis(F &&compute) const {
+    auto key = std::type_index(typeid(AnalysisKey<R, std::decay_t<F>>));
+    auto found = m_analyses.find(key);
+    if (found == m_analyses.end())
+      found = m_analyses.emplace(key, std::make_shared<R>(compute(m_body)))
+                  .first;
+    return *static_cast<const R *>(found->second.get());
+  }
+
+private:
+  template <typename R, typename F> struct AnalysisKey {};
+
+  /// Operand of a prototype: either a shared value or a slot, which is an
+  /// argument index or parameterCount plus prototype index.
+  struct Operand {
+    Value *shared;
+    unsigned slot;
+  };
+
+  mutable Graph m_body;
+  unsigned m_parameterCount;
+  std::vector<Action *> m_prototypes;
+  std::vector<Operand> m_operands;
+  std::vector<unsigned> m_operandOffsets;
+  mutable std::unordered_map<std::type_index, std::shared_ptr<void>>
+      m_analyses;
+};
+
+} // namespace rgc
+#endif // RENDERGRAPHCOMPILER_TEMPLATES_HPP
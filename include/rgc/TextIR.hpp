@@ -0,0 +1,138 @@
+#ifndef RENDERGRAPHCOMPILER_TEXTIR_HPP
+#define RENDERGRAPHCOMPILER_TEXTIR_HPP
+
+#include <istream>
+#include <ostream>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "rgc/Action.hpp"
+#include "rgc/Graph.hpp"
+
+namespace rgc {
+
+/**
+ * Writes graph in textual form, one line per action in graph order:
+ *
+ *   !0 = image R8G8B8A8_UNORM 2d 512x512x1 mips 4 layers 1
+ *   !1 = buffer host 16x256
+ *   %0 = alloc !0
+ *   %1 = real reads [0:1, 0:all] %0[1:1, 0:all] transfer_dst, null
+ *   %2 = alloc !1
+ *   %3 = transfer upload batch 0 offset 0 %2, %1
+ *   $0 = external !1
+ *   %4 = real %3, $0
+ *   %5 = terminate %1
+ *
+ * Actions are numbered by their position, types by their first use, and
+ * every type is defined right before the first line using it, so output
+ * depends on nothing but graph structure. Operands are actions of the
+ * graph, which must precede their users, 'null' constant, or external
+ * values: any other value, numbered by its first use and declared along
+ * with its type right before it. 'reads' gives read range of a
+ * RealAction's useDef resource. Actions of classes unknown to the library
+ * are written as their nearest library base class, types of unknown
+ * classes as 'opaque'.
+ */
+void printGraph(const Graph &graph, std::ostream &os);
+
+/**
+ * @class GraphParser
+ *
+ * Reads graph written by printGraph, appending actions to a graph as soon
+ * as their line is read, without any intermediate representation. Types
+ * are interned into the graph, 'opaque' ones as NullType. External values
+ * are bound by the caller in order of their declaration and must be of
+ * declared types.
+ *
+ * Input is validated: parsing stops at the first malformed line, leaving
+ * actions parsed so far in the graph, and error() describes the problem.
+ * Besides syntax, operands are checked to be of the kind an action expects
+ * and subresource ranges to lie within resources they refer to.
+ * Lines starting with ';' are comments.
+ *
+ */
+class GraphParser {
+public:
+  explicit GraphParser(Graph &graph, std::span<Value *const> externals = {})
+      : m_graph(graph), m_bound(externals) {}
+  GraphParser(const GraphParser &another) = delete;
+  GraphParser &operator=(const GraphParser &another) = delete;
+
+  /**
+   * Parses the whole stream, reading it in large blocks.
+   * @return false on error.
+   */
+  bool parse(std::istream &is);
+
+  /**
+   * Parses a single line, which must not contain a line break.
+   * @return false on error.
+   */
+  bool parseLine(std::string_view line);
+
+  /**
+   * @return number of lines parsed so far, including the malformed one.
+   */
+  auto line() const { return m_line; }
+
+  /**
+   * @return description of the first error or empty string.
+   */
+  auto &error() const { return m_error; }
+
+private:
+  bool m_fail(std::string_view message);
+
+  bool m_parseType();
+
+  bool m_parseAction();
+
+  bool m_parseExternal();
+
+  Type *m_readType();
+
+  Value *m_readOperand();
+
+  bool m_readOperands(size_t count);
+
+  /// Operands must not be terminated and their ranges must lie within them.
+  bool m_checkOperands();
+
+  bool m_checkRange(const SubresourceRange &range, Value *value);
+
+  bool m_checkAction(Value *value);
+
+  bool m_checkKind(Value *value, Action::Kind kind);
+
+  bool m_checkVersion(Value *value);
+
+  bool m_readRange(SubresourceRange &range);
+
+  AccessUsage m_readAccess();
+
+  std::string_view m_word();
+
+  bool m_number(std::uint64_t &value);
+
+  bool m_consume(char c);
+
+  void m_skipSpaces();
+
+  Graph &m_graph;
+  std::span<Value *const> m_bound;
+  std::vector<Type *> m_types;
+  std::vector<Action *> m_actions;
+  std::vector<Value *> m_externals;
+  /// Reused for every line
+  std::vector<Value *> m_operands;
+  std::vector<std::pair<SubresourceRange, AccessUsage>> m_attributes;
+  std::string_view m_rest;
+  size_t m_line = 0;
+  std::string m_error;
+};
+
+} // namespace rgc
+#endif // RENDERGRAPHCOMPILER_TEXTIR_HPP
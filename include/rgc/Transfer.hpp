@@ -0,0 +1,100 @@
+#ifndef RENDERGRAPHCOMPILER_TRANSFER_HPP
+#define RENDERGRAPHCOMPILER_TRANSFER_HPP
+
+#include <vector>
+
+#include "rgc/Action.hpp"
+#include "rgc/Graph.hpp"
+
+namespace rgc {
+
+/**
+ * @class Transfer
+ *
+ * RealAction that copies content of its 'use' buffer into its useDef
+ * buffer, which lives on the other side: Host to Device for uploads and
+ * Device to Host for readbacks.
+ *
+ * Planned transfers are grouped into batches: all transfers of a batch are
+ * adjacent in the graph and go through a shared staging ring at their own
+ * offsets, so a backend can issue them as a single copy.
+ *
+ */
+class Transfer : public RealAction {
+public:
+  enum class Direction { Upload, Readback };
+
+  Transfer(Value *destination, Value *source, Direction direction)
+      : RealAction(destination, source), m_direction(direction) {}
+
+  auto direction() const { return m_direction; }
+
+  auto batch() const { return m_batch; }
+
+  auto stagingOffset() const { return m_stagingOffset; }
+
+  void setStaging(unsigned batch, size_t offset) {
+    m_batch = batch;
+    m_stagingOffset = offset;
+    m_changed();
+  }
+
+  Action *clone(std::span<Value *const> operands) const override {
+    auto *transfer = new Transfer(operands[0], operands[1], m_direction);
+    transfer->setStaging(m_batch, m_stagingOffset);
+    transfer->setAccess(access());
+    transfer->setUseAccess(useAccess());
+    return transfer;
+  }
+
+  void properties(std::vector<std::uint64_t> &words) const override {
+    RealAction::properties(words);
+    words.push_back(static_cast<std::uint64_t>(m_direction));
+    words.push_back(m_batch);
+    words.push_back(m_stagingOffset);
+  }
+
+private:
+  Direction m_direction;
+  unsigned m_batch = 0;
+  size_t m_stagingOffset = 0;
+};
+
+struct TransferOptions {
+  /// Size of staging ring. Batch never exceeds it; buffers larger than the
+  /// ring are not transferred at all, see TransferPlan::oversized.
+  size_t stagingSize = 16u * 1024u * 1024u;
+  size_t alignment = 256u;
+};
+
+struct TransferBatch {
+  Transfer::Direction direction;
+  std::vector<Transfer *> transfers;
+  size_t bytes = 0;
+  /// Earlier batches whose staging memory this batch reuses after the ring
+  /// wrapped around. They must be complete before this batch is staged.
+  std::vector<unsigned> waits;
+};
+
+struct TransferPlan {
+  std::vector<TransferBatch> batches;
+  /// Sources that had to be transferred but don't fit into the staging
+  /// ring. Their readers are left untouched.
+  std::vector<Value *> oversized;
+};
+
+/**
+ * Inserts Transfer actions wherever a Host owned buffer is read by a
+ * RealAction modifying Device owned resource or by a dynamic Allocation of
+ * one (upload), and the other way around (readback). Reads through
+ * Compositions count as well; the Composition then refers to the transfer.
+ * Every transferred value is copied once, however many actions read it.
+ *
+ * Transfers are coalesced into as few batches as possible: a batch is
+ * placed right before the earliest consumer of its transfers and collects
+ * every other transfer whose source is ready by then.
+ */
+TransferPlan planTransfers(Graph &graph, const TransferOptions &options = {});
+
+} // namespace rgc
+#endif // RENDERGRAPHCOMPILER_TRANSFER_HPP
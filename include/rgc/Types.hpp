@@ -1,9 +1,10 @@
 #ifndef RENDERGRAPHCOMPILER_TYPES_HPP
 #define RENDERGRAPHCOMPILER_TYPES_HPP
 
-#include "rgc/Types.hpp"
+#include "rgc/Type.hpp"
 
 #include <algorithm>
+#include <array>
 #include <cassert>
 #include <numeric>
 #include <ranges>
@@ -32,6 +33,9 @@ namespace rgc {
  * in same framebuffer with ScreenBuffer image. ExtentType must be set to auto.
  * mipLevel must be set to 1.
  *
+ * Any image has at least one array layer. Images tied to screen buffer must
+ * have exactly one array layer.
+ *
  */
 class ImageType : public ScalarType {
 public:
@@ -45,9 +49,12 @@ public:
   ImageType(ImageKind ik, PixelFormat pf, ExtentType et, unsigned mipLevels = 1,
             std::span<const size_t, 3> extents = std::array<size_t, 3>{0ull,
                                                                        0ull,
-                                                                       0ull})
+                                                                       0ull},
+            unsigned arrayLayers = 1)
       : ScalarType(ScalarType::Kind::Image, ScalarType::OwnerType::Device),
-        m_kind(ik), m_pixelFormat(pf), m_type(et), m_mipLevels(mipLevels) {
+        m_kind(ik), m_pixelFormat(pf), m_type(et), m_mipLevels(mipLevels),
+        m_arrayLayers(arrayLayers) {
+    assert(m_arrayLayers != 0 && "Image must have at least one layer");
     std::copy(extents.begin(), extents.end(), m_extents.begin());
   }
 
@@ -59,11 +66,83 @@ public:
 
   auto mipLevels() const { return m_mipLevels; }
 
+  auto arrayLayers() const { return m_arrayLayers; }
+
   bool hasDynamicExtents() const {
     return std::ranges::all_of(m_extents, [](auto e) { return e == 0u; });
   }
   std::span<const size_t, 3> extents() const { return m_extents; }
 
+  /**
+   * @return size of one pixel of given format in bytes or 0 for Auto format.
+   */
+  static constexpr size_t pixelSize(PixelFormat pf) {
+    switch (pf) {
+    case PixelFormat::R8_UNORM:
+    case PixelFormat::R8_UINT:
+    case PixelFormat::R8_SINT:
+      return 1;
+    case PixelFormat::R8G8_UNORM:
+    case PixelFormat::R8G8_UINT:
+    case PixelFormat::R8G8_SINT:
+    case PixelFormat::R16_UNORM:
+    case PixelFormat::R16_UINT:
+    case PixelFormat::R16_SINT:
+    case PixelFormat::R16_SFLOAT:
+      return 2;
+    case PixelFormat::R8G8B8A8_UNORM:
+    case PixelFormat::R8G8B8A8_UINT:
+    case PixelFormat::R8G8B8A8_SINT:
+    case PixelFormat::R16G16_UNORM:
+    case PixelFormat::R16G16_UINT:
+    case PixelFormat::R16G16_SINT:
+    case PixelFormat::R16G16_SFLOAT:
+    case PixelFormat::R32_UINT:
+    case PixelFormat::R32_SINT:
+    case PixelFormat::R32_SFLOAT:
+      return 4;
+    case PixelFormat::R16G16B16A16_UNORM:
+    case PixelFormat::R16G16B16A16_UINT:
+    case PixelFormat::R16G16B16A16_SINT:
+    case PixelFormat::R16G16B16A16_SFLOAT:
+    case PixelFormat::R32G32_UINT:
+    case PixelFormat::R32G32_SINT:
+    case PixelFormat::R32G32_SFLOAT:
+      return 8;
+    case PixelFormat::R32G32B32A32_UINT:
+    case PixelFormat::R32G32B32A32_SINT:
+    case PixelFormat::R32G32B32A32_SFLOAT:
+      return 16;
+    case PixelFormat::Auto:
+      return 0;
+    }
+    return 0;
+  }
+
+  /**
+   * @return size of the whole mip chain in bytes. Zero extents of image
+   * with static extents are treated as 1. Returns 0 if size is unknown at
+   * compile time (dynamic extents or Auto pixel format).
+   */
+  static constexpr size_t byteSize(PixelFormat pf, unsigned mipLevels,
+                                   std::span<const size_t, 3> extents,
+                                   unsigned arrayLayers = 1) {
+    if (std::ranges::all_of(extents, [](auto e) { return e == 0u; }))
+      return 0;
+    size_t size = 0;
+    for (unsigned mip = 0; mip < mipLevels; ++mip) {
+      size_t pixels = 1;
+      for (auto e : extents)
+        pixels *= std::max<size_t>(e >> mip, 1u);
+      size += pixels;
+    }
+    return size * arrayLayers * pixelSize(pf);
+  }
+
+  size_t byteSize() const {
+    return byteSize(m_pixelFormat, m_mipLevels, m_extents, m_arrayLayers);
+  }
+
   size_t hash() const {
     auto extentHash = std::accumulate(
         m_extents.begin(), m_extents.end(), (size_t)0u, [](auto s, auto &&e) {
@@ -74,12 +153,14 @@ public:
         extentHash + std::hash<size_t>{}((unsigned long long)m_kind) +
         std::hash<size_t>{}((unsigned long long)m_pixelFormat) +
         std::hash<size_t>{}((unsigned long long)m_type) +
-        std::hash<unsigned>{}(m_mipLevels));
+        std::hash<unsigned>{}(m_mipLevels) +
+        std::hash<unsigned>{}(m_arrayLayers << 16u));
   }
   bool equal(Type *another) const {
     if (auto *i = dynamic_cast<ImageType *>(another)) {
       return m_kind == i->m_kind && m_pixelFormat == i->m_pixelFormat &&
              m_type == i->m_type && m_mipLevels == i->m_mipLevels &&
+             m_arrayLayers == i->m_arrayLayers &&
              std::ranges::equal(m_extents, i->m_extents);
     }
     return false;
@@ -91,15 +172,16 @@ private:
   ExtentType m_type;
 
   unsigned m_mipLevels;
+  unsigned m_arrayLayers;
   std::array<size_t, 3> m_extents;
 };
 
 class AllocatedImageType : public ImageType {
 public:
   AllocatedImageType(PixelFormat pf, ExtentType et, unsigned mipLevels,
-                     std::span<size_t, 3> extents)
-      : ImageType(ImageType::ImageKind::Allocated, pf, et, mipLevels, extents) {
-  }
+                     std::span<size_t, 3> extents, unsigned arrayLayers = 1)
+      : ImageType(ImageType::ImageKind::Allocated, pf, et, mipLevels, extents,
+                  arrayLayers) {}
 };
 
 class ScreenBufferImage : public ImageType {
@@ -171,6 +253,11 @@ public:
 
   size_t elementSize() const { return m_elementSize; }
 
+  /**
+   * @return size of the buffer in bytes or 0 if it has dynamic extents.
+   */
+  size_t byteSize() const { return m_elementSize * m_elementCount; }
+
   size_t hash() const {
     return std::hash<size_t>{}(std::hash<size_t>{}(m_elementSize) +
                                std::hash<size_t>{}(m_elementCount));
@@ -189,5 +276,17 @@ private:
   size_t m_elementCount;
 };
 
+/**
+ * @return size in bytes of resource of given type or 0 if it is not
+ * known at compile time or type is not an Image or Buffer.
+ */
+inline size_t byteSize(const Type *type) {
+  if (auto *image = dynamic_cast<const ImageType *>(type))
+    return image->byteSize();
+  if (auto *buffer = dynamic_cast<const BufferType *>(type))
+    return buffer->byteSize();
+  return 0;
+}
+
 } // namespace rgc
 #endif // RENDERGRAPHCOMPILER_TYPES_HPP
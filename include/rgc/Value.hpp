@@ -1,33 +1,156 @@
 #ifndef RENDERGRAPHCOMPILER_VALUE_HPP
 #define RENDERGRAPHCOMPILER_VALUE_HPP
 
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
 #include <ostream>
-#include <unordered_map>
+#include <ranges>
 
 namespace rgc {
 
 class Action;
 class Type;
+class Value;
+
+/**
+ * @class Use
+ *
+ * Operand slot of an Action. Every Use is linked into intrusive list of uses
+ * of the value it refers to, so a value knows its users without any side
+ * table. Uses are stored by their user, can't be copied and unlink
+ * themselves on destruction.
+ *
+ * A Use doesn't point back at its user: user and operand index are derived
+ * from address of the use and a tag kept in low bits of its m_prev link.
+ * Uses of Terminators and RealActions live inside of the action, so the tag
+ * just names the action class and the operand. Uses of Compositions and
+ * dynamic Allocations live in a separate block ending with a pointer to the
+ * user, and tags of the block spell distance to its end in binary, read in
+ * logarithmic number of steps from any use of the block.
+ *
+ */
+class Use {
+public:
+  Use() = default;
+  Use(const Use &) = delete;
+  Use &operator=(const Use &) = delete;
+  ~Use() { m_set(nullptr); }
+
+  Value *value() const { return m_value; }
+
+  Action *user() const;
+
+  /**
+   * @return position of this use among operands of its user.
+   */
+  unsigned index() const;
+
+  /**
+   * @return next use of the same value or nullptr.
+   */
+  Use *next() const { return m_next; }
+
+private:
+  enum class Tag : std::uintptr_t {
+    // Waymark of a separately allocated block of uses
+    Zero,
+    One,
+    Stop,
+    FullStop,
+    // Uses stored inside of the action
+    TerminatorUse,
+    RealActionUseDef,
+    RealActionUse
+  };
+  static constexpr std::uintptr_t TagMask = 7u;
+
+  explicit Use(Tag tag) : m_prevAndTag(static_cast<std::uintptr_t>(tag)) {}
+
+  Tag m_tag() const { return static_cast<Tag>(m_prevAndTag & TagMask); }
+
+  Use **m_prev() const {
+    return reinterpret_cast<Use **>(m_prevAndTag & ~TagMask);
+  }
+
+  void m_setPrev(Use **prev) {
+    m_prevAndTag = reinterpret_cast<std::uintptr_t>(prev) |
+                   (m_prevAndTag & TagMask);
+  }
+
+  /**
+   * @return end of the separately allocated block this use is stored in.
+   */
+  const Use *m_blockEnd() const;
+
+  void m_set(Value *value);
+
+  friend class Action;
+
+  Value *m_value = nullptr;
+  Use *m_next = nullptr;
+  /// Link pointing at this use, either previous use's m_next or value's
+  /// first use, with the tag in its low bits.
+  std::uintptr_t m_prevAndTag = 0;
+};
+
+class UseIterator {
+public:
+  using difference_type = std::ptrdiff_t;
+  using value_type = Use;
+
+  UseIterator() = default;
+
+  explicit UseIterator(Use *use) : m_use(use) {}
+
+  Use &operator*() const { return *m_use; }
+
+  Use *operator->() const { return m_use; }
+
+  auto &operator++() {
+    m_use = m_use->next();
+    return *this;
+  }
+
+  auto operator++(int) {
+    auto ret = *this;
+    operator++();
+    return ret;
+  }
+
+  bool operator==(const UseIterator &another) const = default;
+
+private:
+  Use *m_use = nullptr;
+};
 
 class Value {
 public:
   explicit Value(Type *type) : m_type(type){};
 
-  auto &users() const { return m_users; }
+  Value(const Value &) = delete;
+  Value &operator=(const Value &) = delete;
 
-  bool unused() const { return m_users.empty(); }
+  /**
+   * @return range of uses of this value, each one referring to its user
+   * and operand index. Order of uses is unspecified.
+   */
+  auto users() const {
+    return std::ranges::subrange{UseIterator{m_firstUse}, UseIterator{}};
+  }
 
-  bool hasUser(Action *action) const { return m_users.contains(action); }
+  bool unused() const { return m_firstUse == nullptr; }
 
-  void addUser(Action *action, unsigned Index) {
-    assert(!m_users.contains(action) && "double insertion");
-    m_users.emplace(action, Index);
+  bool hasUser(const Action *action) const {
+    for (auto *use = m_firstUse; use; use = use->next())
+      if (use->user() == action)
+        return true;
+    return false;
   }
 
   void replaceAllUsesWith(Value *value);
 
-  void removeUser(Action *action) { m_users.erase(action); }
-
   virtual void dump(std::ostream &os) const;
 
   auto *type() const { return m_type; }
@@ -35,10 +158,28 @@ public:
   virtual ~Value();
 
 private:
-  std::unordered_map<Action *, unsigned> m_users;
+  friend class Use;
+
   Type *m_type;
+  Use *m_firstUse = nullptr;
 };
 
+inline void Use::m_set(Value *value) {
+  if (m_value) {
+    *m_prev() = m_next;
+    if (m_next)
+      m_next->m_setPrev(m_prev());
+  }
+  m_value = value;
+  if (!m_value)
+    return;
+  m_next = value->m_firstUse;
+  if (m_next)
+    m_next->m_setPrev(&m_next);
+  m_setPrev(&value->m_firstUse);
+  value->m_firstUse = this;
+}
+
 } // namespace rgc
 
 #endif // RENDERGRAPHCOMPILER_VALUE_HPP
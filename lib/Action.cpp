@@ -1,20 +1,166 @@
+#include <cassert>
+#include <memory>
+#include <new>
+#include <typeinfo>
+
 #include "rgc/Action.hpp"
+#include "rgc/Graph.hpp"
 
 namespace rgc {
-Action::~Action() {
-  // Remove itself as user from all used values
-  for (auto &&val : m_uses)
-    val->removeUser(this);
+
+// Uses are three words, RealAction, the most common action, fits two cache
+// lines with its uses inline. Its object stays 128 bytes as before, but it
+// was accompanied by a heap operand vector and a user map entry per use:
+// about 380 bytes in 7 allocations per RealAction, now 128 bytes in one
+static_assert(sizeof(void *) != 8 || sizeof(Use) == 24);
+static_assert(sizeof(void *) != 8 || sizeof(Value) == 24);
+static_assert(sizeof(void *) != 8 || sizeof(Action) == 56);
+static_assert(sizeof(void *) != 8 || sizeof(Allocation) == 64);
+static_assert(sizeof(void *) != 8 || sizeof(Composition) == 64);
+static_assert(sizeof(void *) != 8 || sizeof(Terminator) == 80);
+static_assert(sizeof(void *) != 8 || sizeof(RealAction) == 128);
+
+const Use *Use::m_blockEnd() const {
+  // Walk up to the nearest Stop, then read the distance spelled by digits
+  // right after it. Uses after the last Stop are close to the end and
+  // FullStop marks the last one.
+  auto *current = this;
+  while (true) {
+    switch ((current++)->m_tag()) {
+    case Tag::Zero:
+    case Tag::One:
+      continue;
+    case Tag::Stop: {
+      ++current;
+      std::ptrdiff_t offset = 1;
+      while (true) {
+        auto tag = current->m_tag();
+        if (tag != Tag::Zero && tag != Tag::One)
+          return current + offset;
+        ++current;
+        offset = (offset << 1) + static_cast<std::ptrdiff_t>(tag);
+      }
+    }
+    default:
+      return current;
+    }
+  }
+}
+
+Use *Action::m_allocateOperands(std::span<Value *const> values) {
+  assert(!values.empty() && "block of uses cannot be empty");
+  auto count = values.size();
+  auto *memory = ::operator new(count * sizeof(Use) + sizeof(Action *));
+  auto *uses = static_cast<Use *>(memory);
+  new (uses + count) Action *(this);
+
+  // Tags are written from the end: a fixed prefix for the last uses, then
+  // for each next Stop the distance to the end in binary, least significant
+  // digit first, so that it reads most significant first after the Stop
+  static constexpr Use::Tag Prefix[] = {
+      Use::Tag::FullStop, Use::Tag::One,  Use::Tag::Stop, Use::Tag::One,
+      Use::Tag::One,      Use::Tag::Stop, Use::Tag::Zero, Use::Tag::One,
+      Use::Tag::One,      Use::Tag::Stop, Use::Tag::Zero, Use::Tag::One,
+      Use::Tag::Zero,     Use::Tag::One,  Use::Tag::Stop, Use::Tag::One,
+      Use::Tag::One,      Use::Tag::One,  Use::Tag::One,  Use::Tag::Stop};
+  std::size_t done = 0;
+  std::size_t digits = 0;
+  for (auto i = count; i-- > 0;) {
+    auto tag = Use::Tag::Stop;
+    if (done < std::size(Prefix)) {
+      tag = Prefix[done];
+      if (done + 1 == std::size(Prefix))
+        digits = std::size(Prefix);
+    } else if (digits) {
+      tag = static_cast<Use::Tag>(digits & 1u);
+      digits >>= 1u;
+    } else {
+      digits = done + 1;
+    }
+    new (uses + i) Use(tag);
+    ++done;
+  }
+
+  m_numOperands = static_cast<std::uint32_t>(count);
+  for (size_t i = 0; i < count; ++i) {
+    assert(values[i] && "value cannot be nullptr");
+    uses[i].m_set(values[i]);
+  }
+  return uses;
+}
+
+void Action::m_freeOperands(Use *uses) {
+  std::destroy_n(uses, m_numOperands);
+  ::operator delete(uses);
+}
+
+void Action::m_changed() {
+  if (auto *graph = this->graph())
+    graph->m_key.reset();
+}
+
+Graph *Action::graph() const { return static_cast<Graph *>(list()); }
+void Action::replaceUse(unsigned Index, Value *value) {
+  assert(Index < m_numOperands && "operand index out of range");
+  assert(value && "value cannot be nullptr");
+  auto &use = m_uses()[Index];
+  auto *old = use.value();
+  use.m_set(value);
+  if (auto *graph = this->graph())
+    graph->m_useReplaced(this, Index, old, value);
+}
+Action *Action::clone(std::span<Value *const> /*operands*/) const {
+  // A subclass cloned by a base would silently lose its class
+  assert(typeid(*this) == typeid(Action) &&
+         "action class must override clone");
+  return nullptr;
+}
+Action *Allocation::clone(std::span<Value *const> operands) const {
+  assert(typeid(*this) == typeid(Allocation) &&
+         "action class must override clone");
+  if (operands.empty())
+    return new Allocation(type());
+  return new Allocation(type(), operands[0]);
+}
+Action *Composition::clone(std::span<Value *const> operands) const {
+  assert(typeid(*this) == typeid(Composition) &&
+         "action class must override clone");
+  return new Composition(type(), operands);
+}
+Action *RealAction::clone(std::span<Value *const> operands) const {
+  assert(typeid(*this) == typeid(RealAction) &&
+         "action class must override clone");
+  auto *action = new RealAction(operands[0], operands[1], m_range, m_useRange,
+                                m_readRange);
+  action->m_subclassData = m_subclassData;
+  return action;
+}
+void RealAction::properties(std::vector<std::uint64_t> &words) const {
+  auto pack = [](const SubresourceRange &range) {
+    return std::uint64_t{range.baseMipLevel} |
+           std::uint64_t{range.mipLevelCount} << 16u |
+           std::uint64_t{range.baseArrayLayer} << 32u |
+           std::uint64_t{range.arrayLayerCount} << 48u;
+  };
+  words.push_back(pack(m_range));
+  words.push_back(pack(m_useRange));
+  words.push_back(pack(m_readRange));
+  words.push_back(m_subclassData);
+}
+Action *Terminator::clone(std::span<Value *const> operands) const {
+  assert(typeid(*this) == typeid(Terminator) &&
+         "action class must override clone");
+  return new Terminator(type(), operands[0]);
 }
 void Action::dump(std::ostream &os) const {
   os << "Action " << this << " [use: ";
-  for (auto &&val : m_uses) {
+  for (auto *val : uses()) {
     os << val << ", ";
   }
-  if (m_uses.empty())
+  if (m_numOperands == 0)
     os << "<empty>";
   os << "] produces: ";
   Value::dump(os);
 }
 
-} // namespace rgc
\ No newline at end of file
+} // namespace rgc
@@ -0,0 +1,316 @@
+#include <algorithm>
+#include <optional>
+#include <span>
+#include <tuple>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "rgc/Budget.hpp"
+#include "rgc/Reordering.hpp"
+#include "rgc/Resolution.hpp"
+#include "rgc/ResourceIndex.hpp"
+#include "rgc/Transfer.hpp"
+#include "rgc/Types.hpp"
+
+namespace rgc {
+
+namespace {
+
+size_t deviceBytes(const Allocation *allocation,
+                   const ResolvedGraph *resolved) {
+  auto *buffer = dynamic_cast<const BufferType *>(allocation->type());
+  if (buffer && buffer->ownerType() == ScalarType::OwnerType::Host)
+    return 0;
+  return ownedBytes(allocation, resolved);
+}
+
+enum class Split { Hoist, Rematerialize, Spill };
+
+struct Candidate {
+  Allocation *resource;
+  Split split;
+  size_t bytes;
+  double cost;
+  /// Positions of the last access before the gap and the first one after it
+  size_t before;
+  size_t after;
+  /// Version of the resource read after the gap
+  Value *version;
+  /// Gap spans the whole range of actions over budget
+  bool covers;
+};
+
+/// Graph in execution order along with Device memory alive at each action.
+struct Timeline {
+  explicit Timeline(Graph &graph, ResourceIndex &index,
+                    const ResolvedGraph *resolved)
+      : actions(graph.begin(), graph.end()), live(actions.size()) {
+    for (size_t i = 0; i < actions.size(); ++i)
+      positions.emplace(actions[i], i);
+    std::vector<size_t> freed(actions.size());
+    size_t alive = 0;
+    for (size_t i = 0; i < actions.size(); ++i) {
+      if (actions[i]->actionKind() == Action::Kind::Allocation) {
+        auto *resource = static_cast<Allocation *>(actions[i]);
+        auto *terminator = index.terminator(resource);
+        auto end =
+            terminator ? positions.at(terminator) : actions.size() - 1;
+        if (auto bytes = deviceBytes(resource, resolved)) {
+          alive += bytes;
+          freed[end] += bytes;
+          lifetimes.push_back({resource, i, end});
+        }
+      }
+      live[i] = alive;
+      alive -= freed[i];
+    }
+  }
+
+  size_t peak() const {
+    return live.empty() ? 0 : std::ranges::max(live);
+  }
+
+  struct Lifetime {
+    Allocation *resource;
+    size_t begin;
+    size_t end;
+  };
+
+  std::vector<Action *> actions;
+  std::unordered_map<const Value *, size_t> positions;
+  std::vector<size_t> live;
+  std::vector<Lifetime> lifetimes;
+};
+
+/**
+ * @return how lifetime of resource may be split around position, or
+ * nullopt if it can't.
+ */
+std::optional<Candidate> evaluate(const Timeline &timeline,
+                                  const Timeline::Lifetime &lifetime,
+                                  size_t position, ResourceIndex &index,
+                                  const BudgetOptions &options) {
+  auto *resource = lifetime.resource;
+  if (!index.terminator(resource) || !resource->operands().empty())
+    return std::nullopt;
+  auto &positions = timeline.positions;
+  auto versionPosition = [&](Value *value) -> std::optional<size_t> {
+    if (index.resourceOf(value) != resource)
+      return std::nullopt;
+    return positions.at(value);
+  };
+
+  auto before = lifetime.begin;
+  auto after = lifetime.end;
+  auto access = [&](size_t at) {
+    if (at < position)
+      before = std::max(before, at);
+    else if (at > position)
+      after = std::min(after, at);
+    return at != position;
+  };
+  auto chain = index.chain(resource);
+  for (auto *version : chain)
+    if (!access(positions.at(version)))
+      return std::nullopt;
+  auto readers = index.readers(resource);
+  for (auto *reader : readers) {
+    auto *realAction = dynamic_cast<RealAction *>(reader);
+    if (!realAction || !versionPosition(realAction->getUse()) ||
+        !access(positions.at(reader)))
+      return std::nullopt;
+  }
+
+  auto bytes = deviceBytes(resource, options.resolved);
+  auto candidate = Candidate{resource, Split::Hoist, bytes, 0.0, before, after,
+                             nullptr, false};
+  if (after == lifetime.end)
+    return candidate;
+
+  // Versions written before the gap and the one read after it
+  auto written = std::ranges::find_if(chain, [&](auto *version) {
+    return positions.at(version) > position;
+  });
+  auto rewritten = std::span{chain.begin(), written};
+  candidate.version = rewritten.empty() ? static_cast<Value *>(resource)
+                                        : rewritten.back();
+  auto versionAt = positions.at(candidate.version);
+  for (auto *reader : readers)
+    if (positions.at(reader) > position &&
+        *versionPosition(static_cast<RealAction *>(reader)->getUse()) <
+            versionAt)
+      return std::nullopt;
+
+  // Rewrites are repeated right before the access after the gap, so what
+  // they read must still be there and unchanged by then
+  auto unchanged = [&](Value *input) {
+    if (dynamic_cast<Constant *>(input))
+      return true;
+    auto *source = index.resourceOf(input);
+    if (!source || source == resource)
+      return false;
+    auto *terminator = index.terminator(source);
+    if (terminator && positions.at(terminator) < after)
+      return false;
+    auto inputAt = positions.at(input);
+    return std::ranges::none_of(index.chain(source), [&](auto *version) {
+      auto at = positions.at(version);
+      return at > inputAt && at < after;
+    });
+  };
+  auto rematerializable = std::ranges::all_of(
+      rewritten, [&](auto *version) { return unchanged(version->getUse()); });
+  auto rematerializeCost = 0.0;
+  for (auto *version : rewritten)
+    rematerializeCost += options.cost ? options.cost(version) : 1.0;
+  auto size = byteSize(resource->type(), options.resolved);
+  auto spillCost = 2.0 * size * options.byteCost;
+  if (rematerializable && (!options.spill || rematerializeCost <= spillCost)) {
+    candidate.split = Split::Rematerialize;
+    candidate.cost = rematerializeCost;
+  } else if (options.spill && size != 0) {
+    candidate.split = Split::Spill;
+    candidate.cost = spillCost;
+  } else {
+    return std::nullopt;
+  }
+  return candidate;
+}
+
+/**
+ * @return Allocation taking place of the resource after the gap or nullptr
+ * if lifetime was shortened in place.
+ */
+Allocation *apply(Graph &graph, const Timeline &timeline,
+                  const Candidate &candidate, size_t position,
+                  ResourceIndex &index, const ResolvedGraph *resolved) {
+  auto *last = timeline.actions[candidate.before];
+  auto *next = timeline.actions[candidate.after];
+  if (candidate.split == Split::Hoist) {
+    graph.moveBefore(index.terminator(candidate.resource),
+                     last->getNextNode());
+    return nullptr;
+  }
+
+  // Uses of the version after the gap, collected before anything is inserted
+  auto *version = candidate.version;
+  std::vector<std::pair<Action *, unsigned>> late;
+  for (auto &use : version->users())
+    if (graph.contains(use.user()) &&
+        timeline.positions.at(use.user()) > position)
+      late.emplace_back(use.user(), use.index());
+
+  auto *copy = new Allocation{candidate.resource->type()};
+  graph.insertBefore(copy, next);
+  Value *replacement = copy;
+  if (candidate.split == Split::Rematerialize) {
+    for (auto *rewrite : index.chain(candidate.resource)) {
+      if (timeline.positions.at(rewrite) > position)
+        break;
+      Value *operands[] = {replacement, rewrite->getUse()};
+      auto *clone = rewrite->clone(operands);
+      graph.insertBefore(clone, next);
+      replacement = clone;
+    }
+  } else {
+    auto *hostType = graph.getType<BufferType>(
+        ScalarType::OwnerType::Host, 1u, byteSize(version->type(), resolved));
+    auto *host = new Allocation{hostType};
+    auto *readback =
+        new Transfer{host, version, Transfer::Direction::Readback};
+    auto *upload = new Transfer{copy, readback, Transfer::Direction::Upload};
+    graph.insertAfter(host, last);
+    graph.insertAfter(readback, host);
+    graph.insertBefore(upload, next);
+    graph.insertBefore(new Terminator{graph.types(), readback}, next);
+    replacement = upload;
+    last = readback;
+  }
+  graph.insertAfter(new Terminator{graph.types(), version}, last);
+  for (auto [user, operand] : late)
+    user->replaceUse(operand, replacement);
+  return copy;
+}
+
+} // namespace
+
+BudgetReport fitMemoryBudget(Graph &graph, size_t budget,
+                             const BudgetOptions &options) {
+  auto report = BudgetReport{};
+  {
+    auto index = ResourceIndex{graph};
+    report.peakBefore = Timeline{graph, index, options.resolved}.peak();
+  }
+  if (options.reorder && report.peakBefore > budget)
+    reorderForMemory(graph, {.resolved = options.resolved});
+
+  auto index = ResourceIndex{graph};
+  // Resources created by splits are never split again, so that every split
+  // removes a gap between accesses of an original resource and the pass
+  // terminates
+  std::unordered_set<const Allocation *> created;
+  while (true) {
+    auto timeline = Timeline{graph, index, options.resolved};
+    auto &live = timeline.live;
+    if (timeline.peak() <= budget) {
+      report.fits = true;
+      report.peakAfter = timeline.peak();
+      return report;
+    }
+
+    // Range of actions over budget around the peak
+    auto position = static_cast<size_t>(std::ranges::max_element(live) -
+                                        live.begin());
+    auto low = position;
+    auto high = position;
+    while (low > 0 && live[low - 1] > budget)
+      --low;
+    while (high + 1 < live.size() && live[high + 1] > budget)
+      ++high;
+    auto excess = live[position] - budget;
+
+    std::vector<Candidate> candidates;
+    std::vector<Allocation *> pinned;
+    for (auto &lifetime : timeline.lifetimes) {
+      if (lifetime.begin > position || lifetime.end < position)
+        continue;
+      auto candidate =
+          lifetime.begin < position && lifetime.end > position &&
+                  !created.contains(lifetime.resource)
+              ? evaluate(timeline, lifetime, position, index, options)
+              : std::nullopt;
+      if (!candidate) {
+        pinned.push_back(lifetime.resource);
+        continue;
+      }
+      candidate->covers = candidate->before < low && candidate->after > high;
+      candidates.push_back(*candidate);
+    }
+    if (candidates.empty()) {
+      report.bottleneck = timeline.actions[position];
+      report.pinned = std::move(pinned);
+      report.peakAfter = live[position];
+      return report;
+    }
+
+    auto &best = *std::ranges::min_element(candidates, {}, [&](auto &c) {
+      return std::tuple{!c.covers, c.bytes < excess, c.cost, -double(c.bytes)};
+    });
+    if (auto *copy =
+            apply(graph, timeline, best, position, index, options.resolved))
+      created.insert(copy);
+    switch (best.split) {
+    case Split::Hoist:
+      ++report.hoisted;
+      break;
+    case Split::Rematerialize:
+      ++report.rematerialized;
+      break;
+    case Split::Spill:
+      ++report.spilled;
+      break;
+    }
+  }
+}
+
+} // namespace rgc
@@ -0,0 +1,226 @@
+#include <algorithm>
+
+#include "rgc/Dependencies.hpp"
+#include "rgc/Suballocation.hpp"
+#include "rgc/Types.hpp"
+
+namespace rgc {
+
+namespace {
+
+struct Layout {
+  unsigned mipLevels = 1;
+  unsigned arrayLayers = 1;
+
+  size_t size() const { return mipLevels * arrayLayers; }
+};
+
+Layout layoutOf(const Type *type) {
+  if (auto *image = dynamic_cast<const ImageType *>(type))
+    return {image->mipLevels(), image->arrayLayers()};
+  return {};
+}
+
+template <typename F>
+void forEachSubresource(const SubresourceRange &range, Layout layout, F &&f) {
+  // Clamping a range out of resource would silently drop its dependencies
+  assert(range.within(layout.mipLevels, layout.arrayLayers) &&
+         "subresource range out of resource");
+  auto clamped = range.clamp(layout.mipLevels, layout.arrayLayers);
+  for (auto mip = clamped.baseMipLevel;
+       mip < clamped.baseMipLevel + clamped.mipLevelCount; ++mip)
+    for (auto layer = clamped.baseArrayLayer;
+         layer < clamped.baseArrayLayer + clamped.arrayLayerCount; ++layer)
+      f(mip * layout.arrayLayers + layer);
+}
+
+/// Collects versions of a resource reachable from value through
+/// compositions.
+void collectVersions(Value *value,
+                     const std::unordered_map<Value *, size_t> &versions,
+                     std::vector<size_t> &out) {
+  if (auto found = versions.find(value); found != versions.end()) {
+    out.push_back(found->second);
+    return;
+  }
+  auto *action = dynamic_cast<Action *>(value);
+  if (action && action->actionKind() == Action::Kind::Composition)
+    for (auto *use : action->uses())
+      collectVersions(use, versions, out);
+}
+
+struct Read {
+  size_t version;
+  Action *reader;
+  SubresourceRange range;
+};
+
+} // namespace
+
+DependencyGraph::DependencyGraph(const Graph &graph, ResourceIndex &index)
+    : m_graph(graph) {
+  std::unordered_map<const Action *, size_t> positions;
+  for (auto *action : graph)
+    positions.emplace(action, positions.size());
+  auto resources = std::vector<Allocation *>(index.resources().begin(),
+                                             index.resources().end());
+  for (auto *resource : resources) {
+    auto chain = index.chain(resource);
+    std::unordered_map<Value *, size_t> versions{{resource, 0u}};
+    for (size_t i = 0; i < chain.size(); ++i)
+      versions.emplace(chain[i], i + 1);
+
+    std::vector<Read> reads;
+    std::vector<size_t> via;
+    for (auto *reader : index.readers(resource)) {
+      auto isRealAction = reader->actionKind() == Action::Kind::RealAction;
+      auto operands = reader->uses();
+      for (unsigned i = isRealAction ? 1u : 0u; i < operands.size(); ++i) {
+        if (auto found = versions.find(operands[i]); found != versions.end()) {
+          auto range = isRealAction
+                           ? static_cast<RealAction *>(reader)->useRange()
+                           : SubresourceRange{};
+          reads.push_back({found->second, reader, range});
+          continue;
+        }
+        via.clear();
+        collectVersions(operands[i], versions, via);
+        for (auto version : via)
+          reads.push_back({version, reader, SubresourceRange{}});
+      }
+    }
+    std::ranges::stable_sort(reads, {}, &Read::version);
+
+    auto layout = layoutOf(resource->type());
+    std::vector<Action *> lastWriter(layout.size(), resource);
+    std::vector<std::vector<Action *>> readers(layout.size());
+    auto nextRead = reads.begin();
+    auto applyReads = [&](size_t version) {
+      for (; nextRead != reads.end() && nextRead->version == version;
+           ++nextRead) {
+        forEachSubresource(nextRead->range, layout, [&](size_t s) {
+          m_add(nextRead->reader, lastWriter[s]);
+          readers[s].push_back(nextRead->reader);
+        });
+      }
+    };
+
+    applyReads(0);
+    for (size_t i = 0; i < chain.size(); ++i) {
+      auto *writer = chain[i];
+      // Subresources only read by the writer are shared with other readers
+      if (!writer->readRange().empty())
+        forEachSubresource(writer->readRange(), layout, [&](size_t s) {
+          m_add(writer, lastWriter[s]);
+          readers[s].push_back(writer);
+        });
+      forEachSubresource(writer->range(), layout, [&](size_t s) {
+        m_add(writer, lastWriter[s]);
+        for (auto *reader : readers[s])
+          m_add(writer, reader);
+        readers[s].clear();
+        lastWriter[s] = writer;
+      });
+      applyReads(i + 1);
+    }
+
+    if (auto *terminator = index.terminator(resource)) {
+      for (size_t s = 0; s < layout.size(); ++s) {
+        m_add(terminator, lastWriter[s]);
+        for (auto *reader : readers[s])
+          m_add(terminator, reader);
+      }
+      // Block must outlive everything suballocated from it
+      for (auto *reader : index.readers(resource))
+        if (auto *sub = dynamic_cast<SubAllocation *>(reader))
+          if (auto *subTerminator = index.terminator(sub))
+            m_add(terminator, subTerminator);
+    }
+
+    // Resources sharing memory of the block are written only once the one
+    // terminated before is gone
+    std::vector<SubAllocation *> subs;
+    for (auto *reader : index.readers(resource))
+      if (auto *sub = dynamic_cast<SubAllocation *>(reader))
+        subs.push_back(sub);
+    std::ranges::sort(subs, {}, &SubAllocation::offset);
+    for (auto first = subs.begin(); first != subs.end(); ++first) {
+      auto end = (*first)->offset() + byteSize((*first)->type());
+      for (auto second = std::next(first);
+           second != subs.end() && (*second)->offset() < end; ++second)
+        for (auto [earlier, later] : {std::pair{*first, *second},
+                                      std::pair{*second, *first}}) {
+          auto *terminator = index.terminator(earlier);
+          auto chain = index.chain(later);
+          if (terminator && !chain.empty() &&
+              positions.at(terminator) < positions.at(chain.front()))
+            m_add(chain.front(), terminator);
+        }
+    }
+  }
+
+  auto deduplicate = [](auto &map) {
+    for (auto &&[action, list] : map) {
+      std::ranges::sort(list);
+      auto duplicates = std::ranges::unique(list);
+      list.erase(duplicates.begin(), duplicates.end());
+    }
+  };
+  deduplicate(m_dependencies);
+  deduplicate(m_dependents);
+}
+
+std::span<Action *const> DependencyGraph::dependencies(Action *action) const {
+  if (auto found = m_dependencies.find(action);
+      found != m_dependencies.end())
+    return found->second;
+  return {};
+}
+
+std::span<Action *const> DependencyGraph::dependents(Action *action) const {
+  if (auto found = m_dependents.find(action); found != m_dependents.end())
+    return found->second;
+  return {};
+}
+
+std::vector<std::vector<Action *>> DependencyGraph::waves() const {
+  std::unordered_map<Action *, size_t> levels;
+  std::vector<std::pair<Action *, size_t>> stack;
+  auto levelOf = [&](Action *root) {
+    stack.emplace_back(root, 0u);
+    while (!stack.empty()) {
+      auto &[action, next] = stack.back();
+      auto deps = dependencies(action);
+      if (next < deps.size()) {
+        auto *dep = deps[next++];
+        if (!levels.contains(dep))
+          stack.emplace_back(dep, 0u);
+        continue;
+      }
+      size_t level = 0;
+      for (auto *dep : deps)
+        level = std::max(level, levels.at(dep) + 1);
+      levels.emplace(action, level);
+      stack.pop_back();
+    }
+    return levels.at(root);
+  };
+
+  std::vector<std::vector<Action *>> waves;
+  for (auto *action : m_graph) {
+    auto level = levels.contains(action) ? levels.at(action) : levelOf(action);
+    if (waves.size() <= level)
+      waves.resize(level + 1);
+    waves[level].push_back(action);
+  }
+  return waves;
+}
+
+void DependencyGraph::m_add(Action *action, Action *dependency) {
+  if (action == dependency)
+    return;
+  m_dependencies[action].push_back(dependency);
+  m_dependents[dependency].push_back(action);
+}
+
+} // namespace rgc
@@ -1,17 +1,165 @@
 #include <algorithm>
+#include <typeinfo>
+#include <unordered_map>
 
 #include "rgc/Graph.hpp"
+#include "rgc/Types.hpp"
 
 namespace rgc {
 Graph::~Graph() {
-  while (!empty()) {
-    std::vector<Action *> unused;
-    std::copy_if(begin(), end(), std::back_inserter(unused),
-                 [](auto *action) { return action->unused(); });
-    assert(!unused.empty() && "cyclic dependency");
-    for (auto *action : unused) {
-      erase(action);
+  // Observers are not interested in tear down of the whole graph
+  m_observers.clear();
+  // Erase actions as soon as they become unused, starting from the unused
+  // ones, so that tear down is linear in graph size
+  std::vector<Action *> unused;
+  for (auto *action : *this)
+    if (action->unused())
+      unused.push_back(action);
+  std::vector<Value *> operands;
+  while (!unused.empty()) {
+    auto *action = unused.back();
+    unused.pop_back();
+    operands.assign(action->uses().begin(), action->uses().end());
+    std::ranges::sort(operands);
+    operands.erase(std::unique(operands.begin(), operands.end()),
+                   operands.end());
+    erase(action);
+    for (auto *operand : operands) {
+      auto *operandAction = dynamic_cast<Action *>(operand);
+      if (operandAction && operandAction->unused() && contains(operandAction))
+        unused.push_back(operandAction);
     }
   }
+  assert(empty() && "cyclic dependency");
+}
+namespace {
+
+/// Appends words describing a type, and types it consists of, to key.
+class KeyBuilder {
+public:
+  KeyBuilder(std::vector<std::type_index> &classes,
+             std::vector<std::uint64_t> &words)
+      : m_classes(classes), m_words(words) {}
+
+  /// Describes type on its first occurrence, later ones refer to it.
+  void type(const Type *type) {
+    if (auto found = m_types.find(type); found != m_types.end()) {
+      m_words.push_back(found->second);
+      return;
+    }
+    m_words.push_back(TypeDefinition);
+    m_types.emplace(type, m_types.size());
+    m_classes.emplace_back(typeid(*type));
+    if (auto *buffer = dynamic_cast<const BufferType *>(type)) {
+      m_words.push_back(buffer->ownerType());
+      m_words.push_back(buffer->elementSize());
+      m_words.push_back(buffer->extent());
+    } else if (auto *image = dynamic_cast<const ImageType *>(type)) {
+      m_words.push_back(static_cast<std::uint64_t>(image->imageKind()));
+      m_words.push_back(static_cast<std::uint64_t>(image->pixelFormat()));
+      m_words.push_back(static_cast<std::uint64_t>(image->extentType()));
+      m_words.push_back(image->mipLevels());
+      m_words.push_back(image->arrayLayers());
+      m_words.insert(m_words.end(), image->extents().begin(),
+                     image->extents().end());
+      if (auto *screen = dynamic_cast<const ScreenBufferImage *>(type))
+        m_words.push_back(screen->getSwapChainID());
+      else if (auto *tied = dynamic_cast<const TiedToScreenBufferImage *>(type))
+        m_words.push_back(tied->getSwapChainID());
+    } else if (auto *aggregate = dynamic_cast<const AggregateType *>(type)) {
+      m_words.push_back(aggregate->aggregateKind());
+      m_words.push_back(aggregate->memberTypes().size());
+      for (auto *member : aggregate->memberTypes())
+        this->type(member);
+    } else if (!dynamic_cast<const NullType *>(type)) {
+      m_words.push_back(type->hash());
+    }
+  }
+
+  // Type references are indices, which never reach these
+  static constexpr std::uint64_t TypeDefinition = ~std::uint64_t{0};
+  static constexpr std::uint64_t Constant = ~std::uint64_t{0} - 1u;
+  static constexpr std::uint64_t External = ~std::uint64_t{0} - 2u;
+
+private:
+  std::vector<std::type_index> &m_classes;
+  std::vector<std::uint64_t> &m_words;
+  std::unordered_map<const Type *, std::uint64_t> m_types;
+};
+
+} // namespace
+
+StructuralKey::StructuralKey(const Graph &graph) {
+  auto builder = KeyBuilder{m_classes, m_words};
+  std::unordered_map<const Value *, std::uint64_t> positions;
+  std::unordered_map<const Value *, std::uint64_t> externals;
+  for (auto *action : graph) {
+    positions.emplace(action, positions.size());
+    m_classes.emplace_back(typeid(*action));
+    builder.type(action->type());
+    m_words.push_back(action->operands().size());
+    for (auto *use : action->uses()) {
+      if (auto found = positions.find(use); found != positions.end()) {
+        m_words.push_back(found->second);
+        continue;
+      }
+      if (auto *constant = dynamic_cast<Constant *>(use)) {
+        m_words.push_back(KeyBuilder::Constant);
+        m_classes.emplace_back(typeid(*constant));
+        m_words.push_back(constant->hash());
+      } else {
+        m_words.push_back(KeyBuilder::External);
+        m_words.push_back(
+            externals.emplace(use, externals.size()).first->second);
+      }
+      builder.type(use->type());
+    }
+    // Number of property words keeps properties of one action apart from
+    // the next action
+    auto count = m_words.size();
+    m_words.push_back(0);
+    action->properties(m_words);
+    m_words[count] = m_words.size() - count - 1u;
+  }
+
+  auto combine = [](size_t seed, size_t value) {
+    return std::hash<size_t>{}(seed * 31u + value);
+  };
+  for (auto &type : m_classes)
+    m_hash = combine(m_hash, type.hash_code());
+  for (auto word : m_words)
+    m_hash = combine(m_hash, std::hash<std::uint64_t>{}(word));
+}
+
+const StructuralKey &Graph::structuralKey() const {
+  if (!m_key)
+    m_key.emplace(*this);
+  return *m_key;
+}
+void Graph::m_inserted(Action *action) {
+  m_key.reset();
+  for (auto *observer : m_observers)
+    observer->actionInserted(action);
+}
+void Graph::m_insertedRange(std::span<Action *const> actions) {
+  m_key.reset();
+  for (auto *observer : m_observers)
+    observer->actionsInserted(actions);
+}
+void Graph::m_erasing(Action *action) {
+  m_key.reset();
+  for (auto *observer : m_observers)
+    observer->actionErased(action);
+}
+void Graph::m_moved(Action *action) {
+  m_key.reset();
+  for (auto *observer : m_observers)
+    observer->actionMoved(action);
+}
+void Graph::m_useReplaced(Action *user, unsigned index, Value *from,
+                          Value *to) {
+  m_key.reset();
+  for (auto *observer : m_observers)
+    observer->useReplaced(user, index, from, to);
 }
 } // namespace rgc
\ No newline at end of file
@@ -0,0 +1,659 @@
+#include <array>
+#include <limits>
+
+#include "rgc/Journal.hpp"
+#include "rgc/Partitioning.hpp"
+#include "rgc/Pipelining.hpp"
+#include "rgc/Suballocation.hpp"
+#include "rgc/Transfer.hpp"
+#include "rgc/Types.hpp"
+
+namespace rgc {
+
+namespace {
+
+constexpr char Magic[] = {'R', 'G', 'C', 'J'};
+constexpr std::uint8_t Version = 2;
+constexpr size_t BlockSize = 64u * 1024u;
+
+/// Record tags.
+enum Record : char {
+  DefineType = 'T',
+  DefineConstant = 'C',
+  DefineExternal = 'X',
+  Insert = 'I',
+  Erase = 'E',
+  Move = 'M',
+  ReplaceUse = 'U'
+};
+
+enum class TypeTag : std::uint8_t {
+  Null,
+  AllocatedImage,
+  ScreenBuffer,
+  TiedToScreenBuffer,
+  Image,
+  Buffer,
+  Unknown = 255
+};
+
+enum class ActionTag : std::uint8_t {
+  Allocation,
+  Composition,
+  RealAction,
+  Terminator,
+  SubAllocation,
+  Import,
+  Transfer,
+  DeviceTransfer
+};
+
+bool within(const SubresourceRange &range, const Value *value) {
+  if (auto *image = dynamic_cast<const ImageType *>(value->type()))
+    return range.within(image->mipLevels(), image->arrayLayers());
+  return range.within(1u, 1u);
+}
+
+ActionTag tagOf(const Action *action) {
+  if (dynamic_cast<const SubAllocation *>(action))
+    return ActionTag::SubAllocation;
+  if (dynamic_cast<const Import *>(action))
+    return ActionTag::Import;
+  if (dynamic_cast<const Transfer *>(action))
+    return ActionTag::Transfer;
+  if (dynamic_cast<const DeviceTransfer *>(action))
+    return ActionTag::DeviceTransfer;
+  switch (action->actionKind()) {
+  case Action::Kind::Allocation:
+    return ActionTag::Allocation;
+  case Action::Kind::Composition:
+    return ActionTag::Composition;
+  case Action::Kind::RealAction:
+    return ActionTag::RealAction;
+  case Action::Kind::Terminator:
+    return ActionTag::Terminator;
+  }
+  return ActionTag::Allocation;
+}
+
+} // namespace
+
+GraphJournal::GraphJournal(Graph &graph, std::ostream &os)
+    : m_graph(graph), m_os(os) {
+  m_buffer.append(Magic, sizeof(Magic));
+  m_byte(Version);
+  // Snapshot of actions inserted before the journal was started
+  for (auto *action : graph)
+    m_insert(action, 0u);
+  graph.addObserver(this);
+}
+
+void GraphJournal::flush() {
+  m_os.write(m_buffer.data(), m_buffer.size());
+  m_written += m_buffer.size();
+  m_buffer.clear();
+}
+
+void GraphJournal::actionInserted(Action *action) {
+  m_insert(action, m_next(action));
+}
+
+void GraphJournal::actionsInserted(std::span<Action *const> actions) {
+  // Actions are recorded in order, each inserted before the one following
+  // the whole range, which is the only one of their successors recorded
+  if (actions.empty())
+    return;
+  auto next = m_next(actions.back());
+  for (auto *action : actions)
+    m_insert(action, next);
+}
+
+void GraphJournal::m_insert(Action *action, std::uint64_t next) {
+  auto tag = tagOf(action);
+  // Everything referred to by the record is defined before it
+  auto type = m_type(action->type());
+  m_operands.clear();
+  for (auto *use : action->uses())
+    m_operands.push_back(m_value(use));
+  // Action used before being inserted already has an external ID
+  auto [found, inserted] = m_values.emplace(action, m_nextValue);
+  if (inserted)
+    ++m_nextValue;
+  m_externals.erase(action);
+
+  m_byte(Record::Insert);
+  m_varint(found->second);
+  m_varint(next);
+  m_byte(static_cast<std::uint8_t>(tag));
+  m_varint(type);
+  m_varint(m_operands.size());
+  for (auto operand : m_operands)
+    m_varint(operand);
+
+  auto realAction = [&](const RealAction *action) {
+    m_byte(static_cast<std::uint8_t>(action->access()));
+    m_byte(static_cast<std::uint8_t>(action->useAccess()));
+  };
+  switch (tag) {
+  case ActionTag::RealAction: {
+    auto *real = static_cast<const RealAction *>(action);
+    for (auto &range : {real->range(), real->useRange(), real->readRange()}) {
+      m_varint(range.baseMipLevel);
+      m_varint(range.mipLevelCount);
+      m_varint(range.baseArrayLayer);
+      m_varint(range.arrayLayerCount);
+    }
+    realAction(real);
+    break;
+  }
+  case ActionTag::SubAllocation:
+    m_varint(static_cast<const SubAllocation *>(action)->offset());
+    break;
+  case ActionTag::Import: {
+    auto *import = static_cast<const Import *>(action);
+    m_varint(import->resourceID());
+    m_byte(static_cast<std::uint8_t>(import->access()));
+    break;
+  }
+  case ActionTag::Transfer: {
+    auto *transfer = static_cast<const Transfer *>(action);
+    m_byte(static_cast<std::uint8_t>(transfer->direction()));
+    m_varint(transfer->batch());
+    m_varint(transfer->stagingOffset());
+    realAction(transfer);
+    break;
+  }
+  case ActionTag::DeviceTransfer: {
+    auto *transfer = static_cast<const DeviceTransfer *>(action);
+    m_varint(transfer->from());
+    m_varint(transfer->to());
+    realAction(transfer);
+    break;
+  }
+  default:
+    break;
+  }
+  m_flushIfFull();
+}
+
+void GraphJournal::actionErased(Action *action) {
+  auto found = m_values.find(action);
+  assert(found != m_values.end() && "erased action was not recorded");
+  m_byte(Record::Erase);
+  m_varint(found->second);
+  m_values.erase(found);
+  for (auto *use : action->uses())
+    m_release(use, action);
+  m_flushIfFull();
+}
+
+void GraphJournal::actionMoved(Action *action) {
+  auto next = m_next(action);
+  m_byte(Record::Move);
+  m_varint(m_values.at(action));
+  m_varint(next);
+  m_flushIfFull();
+}
+
+void GraphJournal::useReplaced(Action *user, unsigned index, Value *from,
+                               Value *to) {
+  auto value = m_value(to);
+  m_byte(Record::ReplaceUse);
+  m_varint(m_values.at(user));
+  m_varint(index);
+  m_varint(value);
+  m_release(from, nullptr);
+  m_flushIfFull();
+}
+
+GraphJournal::~GraphJournal() {
+  m_graph.removeObserver(this);
+  flush();
+}
+
+void GraphJournal::m_varint(std::uint64_t value) {
+  while (value >= 0x80u) {
+    m_byte(static_cast<std::uint8_t>(value | 0x80u));
+    value >>= 7u;
+  }
+  m_byte(static_cast<std::uint8_t>(value));
+}
+
+std::uint64_t GraphJournal::m_type(const Type *type) {
+  if (auto found = m_types.find(type); found != m_types.end())
+    return found->second;
+
+  // Type IDs are implicit: types are numbered in order of definition
+  auto *image = dynamic_cast<const ImageType *>(type);
+  auto *buffer = dynamic_cast<const BufferType *>(type);
+  m_byte(Record::DefineType);
+  if (dynamic_cast<const NullType *>(type)) {
+    m_byte(static_cast<std::uint8_t>(TypeTag::Null));
+  } else if (auto *screen = dynamic_cast<const ScreenBufferImage *>(type)) {
+    m_byte(static_cast<std::uint8_t>(TypeTag::ScreenBuffer));
+    m_varint(screen->getSwapChainID());
+  } else if (auto *tied =
+                 dynamic_cast<const TiedToScreenBufferImage *>(type)) {
+    m_byte(static_cast<std::uint8_t>(TypeTag::TiedToScreenBuffer));
+    m_varint(static_cast<unsigned>(tied->pixelFormat()));
+    m_varint(tied->getSwapChainID());
+  } else if (image) {
+    auto tag = dynamic_cast<const AllocatedImageType *>(type)
+                   ? TypeTag::AllocatedImage
+                   : TypeTag::Image;
+    m_byte(static_cast<std::uint8_t>(tag));
+    if (tag == TypeTag::Image)
+      m_varint(static_cast<unsigned>(image->imageKind()));
+    m_varint(static_cast<unsigned>(image->pixelFormat()));
+    m_varint(static_cast<unsigned>(image->extentType()));
+    m_varint(image->mipLevels());
+    for (auto extent : image->extents())
+      m_varint(extent);
+    m_varint(image->arrayLayers());
+  } else if (buffer) {
+    m_byte(static_cast<std::uint8_t>(TypeTag::Buffer));
+    m_varint(static_cast<unsigned>(buffer->ownerType()));
+    m_varint(buffer->elementSize());
+    m_varint(buffer->extent());
+  } else {
+    m_byte(static_cast<std::uint8_t>(TypeTag::Unknown));
+  }
+  auto id = m_types.size();
+  m_types.emplace(type, id);
+  return id;
+}
+
+std::uint64_t GraphJournal::m_value(Value *value) {
+  if (auto found = m_values.find(value); found != m_values.end())
+    return found->second;
+
+  // Value that is not an action of the graph: either a constant or a value
+  // from outside, which includes actions that are not inserted yet
+  auto id = m_nextValue++;
+  m_values.emplace(value, id);
+  if (dynamic_cast<NullConstant *>(value)) {
+    m_byte(Record::DefineConstant);
+    m_varint(id);
+    m_byte(0u);
+  } else {
+    m_externals.insert(value);
+    auto type = m_type(value->type());
+    m_byte(Record::DefineExternal);
+    m_varint(id);
+    m_varint(type);
+  }
+  return id;
+}
+
+void GraphJournal::m_release(Value *value, const Action *erased) {
+  if (!m_externals.contains(value))
+    return;
+  for (auto &use : value->users())
+    if (use.user() != erased && use.user()->graph() == &m_graph)
+      return;
+  // Value may be deleted now and its address reused by another one
+  m_externals.erase(value);
+  m_values.erase(value);
+}
+
+std::uint64_t GraphJournal::m_next(const Action *action) {
+  auto *next = action->getNextNode();
+  return next ? m_values.at(next) : 0u;
+}
+
+void GraphJournal::m_flushIfFull() {
+  if (m_buffer.size() >= BlockSize)
+    flush();
+}
+
+JournalReplay::JournalReplay(std::istream &is) : m_is(is) {
+  char magic[sizeof(Magic)] = {};
+  m_is.read(magic, sizeof(magic));
+  if (m_is.gcount() != sizeof(magic) ||
+      !std::equal(magic, magic + sizeof(magic), Magic))
+    m_fail("not a graph journal");
+  else if (m_is.get() != Version)
+    m_fail("unsupported journal version");
+}
+
+bool JournalReplay::step() {
+  if (!m_error.empty())
+    return false;
+  auto record = m_is.get();
+  if (record == std::istream::traits_type::eof())
+    return false;
+
+  switch (record) {
+  case Record::DefineType: {
+    auto *type = m_readType();
+    if (!type)
+      return false;
+    m_types.push_back(type);
+    break;
+  }
+  case Record::DefineConstant: {
+    auto id = m_varint();
+    if (m_byte() != 0u)
+      return m_fail("unknown constant");
+    if (!m_define(id, m_graph.getConstant<NullConstant>(m_graph.types())))
+      return false;
+    break;
+  }
+  case Record::DefineExternal: {
+    auto id = m_varint();
+    auto *type = m_type(m_varint());
+    if (!type)
+      return false;
+    auto placeholder = std::make_unique<Allocation>(type);
+    if (!m_define(id, placeholder.get()))
+      return false;
+    m_externals.emplace(id, std::move(placeholder));
+    break;
+  }
+  case Record::Insert: {
+    auto id = m_varint();
+    auto next = m_varint();
+    auto *before = next ? m_action(next) : nullptr;
+    if (!m_error.empty())
+      return false;
+    // Action may have been used before it was inserted
+    auto external = m_externals.find(id);
+    if (external == m_externals.end() && id != m_values.size())
+      return m_fail("values must be defined in order of their IDs");
+    auto *action = m_readAction(m_byte());
+    if (!action)
+      return false;
+    if (before)
+      m_graph.insertBefore(action, before);
+    else
+      m_graph.push_back(action);
+    if (external != m_externals.end()) {
+      external->second->replaceAllUsesWith(action);
+      m_externals.erase(external);
+      m_values[id] = action;
+    } else {
+      m_define(id, action);
+    }
+    break;
+  }
+  case Record::Erase: {
+    auto id = m_varint();
+    auto *action = m_action(id);
+    if (!action)
+      return false;
+    if (!action->unused())
+      return m_fail("erased action is still in use");
+    m_graph.erase(action);
+    m_values[id] = nullptr;
+    break;
+  }
+  case Record::Move: {
+    auto *action = m_action(m_varint());
+    auto next = m_varint();
+    auto *before = next ? m_action(next) : nullptr;
+    if (!m_error.empty())
+      return false;
+    m_graph.moveBefore(action, before);
+    break;
+  }
+  case Record::ReplaceUse: {
+    auto *user = m_action(m_varint());
+    auto index = m_varint();
+    auto *value = m_value(m_varint());
+    if (!m_error.empty())
+      return false;
+    if (index >= user->operands().size())
+      return m_fail("operand index out of range");
+    user->replaceUse(index, value);
+    break;
+  }
+  default:
+    return m_fail("unknown record");
+  }
+  ++m_records;
+  return true;
+}
+
+bool JournalReplay::m_fail(std::string_view message) {
+  if (m_error.empty())
+    m_error = message;
+  return false;
+}
+
+std::uint8_t JournalReplay::m_byte() {
+  auto byte = m_is.get();
+  if (byte == std::istream::traits_type::eof()) {
+    m_fail("truncated journal");
+    return 0;
+  }
+  return static_cast<std::uint8_t>(byte);
+}
+
+std::uint64_t JournalReplay::m_varint() {
+  std::uint64_t value = 0;
+  for (unsigned shift = 0; shift < 64u; shift += 7u) {
+    auto byte = m_is.get();
+    if (byte == std::istream::traits_type::eof()) {
+      m_fail("truncated journal");
+      return 0;
+    }
+    value |= std::uint64_t(byte & 0x7Fu) << shift;
+    if (!(byte & 0x80u))
+      return value;
+  }
+  m_fail("malformed integer");
+  return 0;
+}
+
+template <typename T> T JournalReplay::m_integer() {
+  auto value = m_varint();
+  if (value > std::numeric_limits<T>::max()) {
+    m_fail("integer out of range");
+    return 0;
+  }
+  return static_cast<T>(value);
+}
+
+template <typename E> E JournalReplay::m_enum(std::uint64_t value, E last) {
+  if (value > static_cast<std::uint64_t>(last)) {
+    m_fail("enumerator out of range");
+    return E{};
+  }
+  return static_cast<E>(value);
+}
+
+Type *JournalReplay::m_readType() {
+  auto tag = m_byte();
+  switch (static_cast<TypeTag>(tag)) {
+  case TypeTag::ScreenBuffer: {
+    auto swapChainID = m_integer<unsigned>();
+    if (!m_error.empty())
+      return nullptr;
+    return m_graph.getType<ScreenBufferImage>(swapChainID);
+  }
+  case TypeTag::TiedToScreenBuffer: {
+    auto format = m_enum(m_varint(), ImageType::PixelFormat::Auto);
+    auto swapChainID = m_integer<unsigned>();
+    if (!m_error.empty())
+      return nullptr;
+    return m_graph.getType<TiedToScreenBufferImage>(format, swapChainID);
+  }
+  case TypeTag::AllocatedImage:
+  case TypeTag::Image: {
+    auto kind = ImageType::ImageKind::Allocated;
+    if (tag == static_cast<std::uint8_t>(TypeTag::Image))
+      kind = m_enum(m_varint(), ImageType::ImageKind::TiedToScreenBuffer);
+    auto format = m_enum(m_varint(), ImageType::PixelFormat::Auto);
+    auto extentType = m_enum(m_varint(), ImageType::ExtentType::Auto);
+    auto mipLevels = m_integer<unsigned>();
+    std::array<size_t, 3> extents;
+    for (auto &extent : extents)
+      extent = m_integer<size_t>();
+    auto arrayLayers = m_integer<unsigned>();
+    if (!m_error.empty())
+      return nullptr;
+    if (arrayLayers == 0) {
+      m_fail("image without array layers");
+      return nullptr;
+    }
+    if (tag == static_cast<std::uint8_t>(TypeTag::AllocatedImage))
+      return m_graph.getType<AllocatedImageType>(format, extentType, mipLevels,
+                                                 extents, arrayLayers);
+    return m_graph.getType<ImageType>(kind, format, extentType, mipLevels,
+                                      extents, arrayLayers);
+  }
+  case TypeTag::Buffer: {
+    auto owner = m_enum(m_varint(), ScalarType::OwnerType::None);
+    auto elementSize = m_integer<size_t>();
+    auto elementCount = m_integer<size_t>();
+    if (!m_error.empty())
+      return nullptr;
+    if (elementSize == 0) {
+      m_fail("buffer element size can't be zero");
+      return nullptr;
+    }
+    return m_graph.getType<BufferType>(owner, elementSize, elementCount);
+  }
+  case TypeTag::Null:
+  case TypeTag::Unknown:
+    if (!m_error.empty())
+      return nullptr;
+    return m_graph.getType<NullType>();
+  }
+  m_fail("unknown type");
+  return nullptr;
+}
+
+Action *JournalReplay::m_readAction(std::uint8_t tag) {
+  auto *type = m_type(m_varint());
+  auto count = m_varint();
+  std::vector<Value *> operands;
+  for (std::uint64_t i = 0; i < count && m_error.empty(); ++i)
+    operands.push_back(m_value(m_varint()));
+  if (!type)
+    return nullptr;
+
+  auto arity = [&](size_t min, size_t max) {
+    if (operands.size() < min || operands.size() > max)
+      m_fail("wrong number of operands");
+    return m_error.empty();
+  };
+  // Every field of the record is read before the action is created
+  std::array<AccessUsage, 2> accesses = {};
+  auto readAccesses = [&] {
+    for (auto &access : accesses)
+      access = m_enum(m_byte(), AccessUsage::TransferDst);
+    return arity(2u, 2u);
+  };
+  auto realAction = [&](RealAction *action) {
+    action->setAccess(accesses[0]);
+    action->setUseAccess(accesses[1]);
+    return action;
+  };
+  switch (static_cast<ActionTag>(tag)) {
+  case ActionTag::Allocation:
+    if (!arity(0u, 1u))
+      return nullptr;
+    if (operands.empty())
+      return new Allocation{type};
+    return new Allocation{type, operands[0]};
+  case ActionTag::Composition:
+    if (!arity(1u, count))
+      return nullptr;
+    return new Composition{type, operands};
+  case ActionTag::RealAction: {
+    std::array<SubresourceRange, 3> ranges;
+    for (auto &range : ranges) {
+      range.baseMipLevel = m_integer<std::uint16_t>();
+      range.mipLevelCount = m_integer<std::uint16_t>();
+      range.baseArrayLayer = m_integer<std::uint16_t>();
+      range.arrayLayerCount = m_integer<std::uint16_t>();
+    }
+    if (!readAccesses())
+      return nullptr;
+    if (!within(ranges[0], operands[0]) || !within(ranges[1], operands[1]) ||
+        (!ranges[2].empty() && !within(ranges[2], operands[0]))) {
+      m_fail("subresource range out of resource");
+      return nullptr;
+    }
+    return realAction(new RealAction{operands[0], operands[1], ranges[0],
+                                     ranges[1], ranges[2]});
+  }
+  case ActionTag::Terminator:
+    if (!arity(1u, 1u))
+      return nullptr;
+    return new Terminator{m_graph.types(), operands[0]};
+  case ActionTag::SubAllocation: {
+    auto offset = m_integer<size_t>();
+    if (!arity(1u, 1u))
+      return nullptr;
+    return new SubAllocation{type, operands[0], offset};
+  }
+  case ActionTag::Import: {
+    auto resourceID = m_integer<unsigned>();
+    auto access = m_enum(m_byte(), Import::Access::History);
+    if (!arity(0u, 0u))
+      return nullptr;
+    return new Import{type, resourceID, access};
+  }
+  case ActionTag::Transfer: {
+    auto direction = m_enum(m_byte(), Transfer::Direction::Readback);
+    auto batch = m_integer<unsigned>();
+    auto offset = m_integer<size_t>();
+    if (!readAccesses())
+      return nullptr;
+    auto *transfer = new Transfer{operands[0], operands[1], direction};
+    transfer->setStaging(batch, offset);
+    return realAction(transfer);
+  }
+  case ActionTag::DeviceTransfer: {
+    auto from = m_integer<unsigned>();
+    auto to = m_integer<unsigned>();
+    if (!readAccesses())
+      return nullptr;
+    return realAction(
+        new DeviceTransfer{operands[0], operands[1], from, to});
+  }
+  }
+  m_fail("unknown action");
+  return nullptr;
+}
+
+Type *JournalReplay::m_type(std::uint64_t id) {
+  if (!m_error.empty())
+    return nullptr;
+  if (id >= m_types.size()) {
+    m_fail("undefined type");
+    return nullptr;
+  }
+  return m_types[id];
+}
+
+Value *JournalReplay::m_value(std::uint64_t id) {
+  if (!m_error.empty())
+    return nullptr;
+  if (id >= m_values.size() || !m_values[id]) {
+    m_fail("undefined value");
+    return nullptr;
+  }
+  return m_values[id];
+}
+
+Action *JournalReplay::m_action(std::uint64_t id) {
+  auto *value = m_value(id);
+  auto *action = dynamic_cast<Action *>(value);
+  if (value && (!action || action->graph() != &m_graph))
+    m_fail("value is not an action of the graph");
+  return m_error.empty() ? action : nullptr;
+}
+
+bool JournalReplay::m_define(std::uint64_t id, Value *value) {
+  if (!m_error.empty())
+    return false;
+  if (id != m_values.size())
+    return m_fail("values must be defined in order of their IDs");
+  m_values.push_back(value);
+  return true;
+}
+
+} // namespace rgc
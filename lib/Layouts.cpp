@@ -0,0 +1,311 @@
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <map>
+
+#include "rgc/Layouts.hpp"
+#include "rgc/ResourceIndex.hpp"
+#include "rgc/Types.hpp"
+
+namespace rgc {
+
+namespace {
+
+constexpr unsigned LayoutCount =
+    static_cast<unsigned>(ImageLayout::Present) + 1;
+
+/// Cost of accessing an image in layout other than the optimal one for the
+/// usage, relative to a single transition. General layout disables
+/// compression of attachments, so it is worth a transition.
+constexpr unsigned GeneralPenalty = 2;
+
+/// Set of layouts, a bit per ImageLayout.
+using LayoutMask = std::uint8_t;
+
+constexpr LayoutMask bit(ImageLayout layout) {
+  return 1u << static_cast<unsigned>(layout);
+}
+
+/// @return optimal layout for the usage. Any usage accepts General layout
+/// as well.
+ImageLayout optimal(AccessUsage usage) {
+  switch (usage) {
+  case AccessUsage::ColorAttachment:
+    return ImageLayout::ColorAttachment;
+  case AccessUsage::DepthStencilAttachment:
+    return ImageLayout::DepthStencilAttachment;
+  case AccessUsage::Sampled:
+    return ImageLayout::ShaderReadOnly;
+  case AccessUsage::TransferSrc:
+    return ImageLayout::TransferSrc;
+  case AccessUsage::TransferDst:
+    return ImageLayout::TransferDst;
+  case AccessUsage::Storage:
+  case AccessUsage::Unknown:
+    return ImageLayout::General;
+  }
+  return ImageLayout::General;
+}
+
+struct Layout {
+  unsigned mipLevels = 1;
+  unsigned arrayLayers = 1;
+
+  size_t size() const { return mipLevels * arrayLayers; }
+};
+
+template <typename F>
+void forEachSubresource(const SubresourceRange &range, Layout layout, F &&f) {
+  assert(range.within(layout.mipLevels, layout.arrayLayers) &&
+         "subresource range out of resource");
+  auto clamped = range.clamp(layout.mipLevels, layout.arrayLayers);
+  for (auto mip = clamped.baseMipLevel;
+       mip < clamped.baseMipLevel + clamped.mipLevelCount; ++mip)
+    for (auto layer = clamped.baseArrayLayer;
+         layer < clamped.baseArrayLayer + clamped.arrayLayerCount; ++layer)
+      f(mip * layout.arrayLayers + layer);
+}
+
+/// Merges sorted subresource indices into as few ranges as possible.
+std::vector<SubresourceRange> toRanges(std::span<const size_t> subresources,
+                                       Layout layout) {
+  // Runs of consecutive layers of every mip level
+  using Run = std::pair<unsigned, unsigned>;
+  std::vector<std::vector<Run>> runs(layout.mipLevels);
+  for (auto s : subresources) {
+    auto &mipRuns = runs[s / layout.arrayLayers];
+    unsigned layer = s % layout.arrayLayers;
+    if (!mipRuns.empty() &&
+        mipRuns.back().first + mipRuns.back().second == layer)
+      ++mipRuns.back().second;
+    else
+      mipRuns.emplace_back(layer, 1u);
+  }
+  std::vector<SubresourceRange> ranges;
+  for (unsigned mip = 0; mip < layout.mipLevels;) {
+    auto end = mip + 1;
+    while (end < layout.mipLevels && runs[end] == runs[mip])
+      ++end;
+    for (auto [layer, count] : runs[mip])
+      ranges.push_back({static_cast<std::uint16_t>(mip),
+                        static_cast<std::uint16_t>(end - mip),
+                        static_cast<std::uint16_t>(layer),
+                        static_cast<std::uint16_t>(count)});
+    mip = end;
+  }
+  return ranges;
+}
+
+/// Collects versions of a resource that value is or, if it is a
+/// Composition, that it is composed of.
+void collectVersions(Value *value,
+                     const std::unordered_map<Value *, size_t> &versions,
+                     std::vector<size_t> &out) {
+  if (auto found = versions.find(value); found != versions.end()) {
+    out.push_back(found->second);
+    return;
+  }
+  auto *action = dynamic_cast<Action *>(value);
+  if (action && action->actionKind() == Action::Kind::Composition)
+    for (auto *use : action->uses())
+      collectVersions(use, versions, out);
+}
+
+struct Access {
+  Action *action;
+  unsigned index;
+  ImageLayout optimal;
+  /// Version of resource that is written or read.
+  size_t version;
+  /// Exclusive access forms a group of its own.
+  bool exclusive;
+};
+
+struct Group {
+  LayoutMask layouts = ~LayoutMask{0};
+  std::array<unsigned, LayoutCount> penalty{};
+  std::vector<size_t> members;
+
+  void add(size_t id, const Access &access) {
+    auto optimalLayout = bit(access.optimal);
+    // Present is the only layout accepted for presentation
+    if (access.optimal != ImageLayout::Present)
+      optimalLayout |= bit(ImageLayout::General);
+    layouts &= optimalLayout;
+    for (unsigned layout = 0; layout < LayoutCount; ++layout)
+      if (layout != static_cast<unsigned>(access.optimal))
+        penalty[layout] += GeneralPenalty;
+    members.push_back(id);
+  }
+};
+
+/// @return layout of every group, such that the sum of transitions and
+/// penalties of non-optimal layouts is minimal.
+std::vector<ImageLayout> pickLayouts(std::span<const Group> groups) {
+  constexpr auto Infinity = std::numeric_limits<unsigned>::max();
+  using Costs = std::array<unsigned, LayoutCount>;
+  std::vector<Costs> costs(groups.size());
+  std::vector<std::array<std::uint8_t, LayoutCount>> previous(groups.size());
+  auto prevCosts = Costs{};
+  prevCosts.fill(Infinity);
+  prevCosts[static_cast<unsigned>(ImageLayout::Undefined)] = 0;
+  for (size_t g = 0; g < groups.size(); ++g) {
+    auto mask =
+        groups[g].layouts ? groups[g].layouts : bit(ImageLayout::General);
+    costs[g].fill(Infinity);
+    for (unsigned to = 0; to < LayoutCount; ++to) {
+      if (!(mask & (1u << to)))
+        continue;
+      // Staying in the same layout wins ties
+      for (unsigned from = 0; from < LayoutCount; ++from) {
+        if (prevCosts[from] == Infinity)
+          continue;
+        auto cost = prevCosts[from] + (from != to) + groups[g].penalty[to];
+        if (cost < costs[g][to] || (cost == costs[g][to] && from == to)) {
+          costs[g][to] = cost;
+          previous[g][to] = from;
+        }
+      }
+    }
+    prevCosts = costs[g];
+  }
+
+  std::vector<ImageLayout> layouts(groups.size());
+  if (groups.empty())
+    return layouts;
+  auto layout = static_cast<unsigned>(std::ranges::min_element(prevCosts) -
+                                      prevCosts.begin());
+  for (size_t g = groups.size(); g-- > 0;) {
+    layouts[g] = static_cast<ImageLayout>(layout);
+    layout = previous[g][layout];
+  }
+  return layouts;
+}
+
+} // namespace
+
+ImageLayout LayoutPlan::layout(const Action *action, unsigned index) const {
+  if (auto found = m_layouts.find({action, index}); found != m_layouts.end())
+    return found->second;
+  return ImageLayout::Undefined;
+}
+
+LayoutPlan planLayouts(Graph &graph) {
+  auto plan = LayoutPlan{};
+  std::unordered_map<const Action *, size_t> positions;
+  for (auto *action : graph)
+    positions.emplace(action, positions.size());
+
+  auto index = ResourceIndex{graph};
+  auto resources = std::vector<Allocation *>(index.resources().begin(),
+                                             index.resources().end());
+  std::ranges::sort(resources, {}, [&](auto *r) { return positions.at(r); });
+  std::vector<std::pair<size_t, LayoutTransition>> transitions;
+  for (auto *resource : resources) {
+    auto *image = dynamic_cast<const ImageType *>(resource->type());
+    if (!image)
+      continue;
+    auto layout = Layout{image->mipLevels(), image->arrayLayers()};
+
+    std::vector<Access> accesses;
+    std::vector<std::vector<size_t>> sequences(layout.size());
+    auto add = [&](Access access, const SubresourceRange &range) {
+      forEachSubresource(range, layout, [&](size_t s) {
+        sequences[s].push_back(accesses.size());
+      });
+      accesses.push_back(access);
+    };
+
+    auto chain = index.chain(resource);
+    std::unordered_map<Value *, size_t> versions{{resource, 0u}};
+    for (size_t i = 0; i < chain.size(); ++i) {
+      versions.emplace(chain[i], i + 1);
+      if (!chain[i]->readRange().empty())
+        add({chain[i], 2u, optimal(chain[i]->useAccess()), i, false},
+            chain[i]->readRange());
+      add({chain[i], 0u, optimal(chain[i]->access()), i + 1, true},
+          chain[i]->range());
+    }
+    std::vector<size_t> via;
+    for (auto *reader : index.readers(resource)) {
+      if (reader->actionKind() != Action::Kind::RealAction)
+        continue;
+      auto *realAction = static_cast<RealAction *>(reader);
+      if (auto found = versions.find(realAction->getUse());
+          found != versions.end()) {
+        add({reader, 1u, optimal(realAction->useAccess()), found->second,
+             false},
+            realAction->useRange());
+        continue;
+      }
+      // Read through Compositions covers whole image
+      via.clear();
+      collectVersions(realAction->getUse(), versions, via);
+      for (auto version : via)
+        add({reader, 1u, optimal(realAction->useAccess()), version, false},
+            {});
+    }
+    auto *terminator = index.terminator(resource);
+    if (terminator && image->imageKind() == ImageType::ImageKind::ScreenBuffer)
+      add({terminator, 0u, ImageLayout::Present, chain.size() + 1, true},
+          {});
+
+    // Subresources sharing a sequence of accesses are planned together,
+    // ordered by their first subresource
+    std::map<std::vector<size_t>, std::vector<size_t>> patterns;
+    for (size_t s = 0; s < sequences.size(); ++s) {
+      auto &sequence = sequences[s];
+      std::ranges::stable_sort(sequence, {}, [&](size_t a) {
+        return std::pair{accesses[a].version, !accesses[a].exclusive};
+      });
+      if (!sequence.empty())
+        patterns[sequence].push_back(s);
+    }
+    std::vector<decltype(patterns)::value_type *> ordered;
+    for (auto &pattern : patterns)
+      ordered.push_back(&pattern);
+    std::ranges::sort(ordered, {},
+                      [](auto *pattern) { return pattern->second.front(); });
+
+    for (auto *pattern : ordered) {
+      auto &[sequence, subresources] = *pattern;
+      std::vector<Group> groups;
+      for (size_t i = 0; i < sequence.size(); ++i) {
+        auto &access = accesses[sequence[i]];
+        auto &prev = accesses[sequence[i ? i - 1 : 0]];
+        if (i == 0 || access.exclusive || prev.exclusive ||
+            access.version != prev.version)
+          groups.emplace_back();
+        groups.back().add(sequence[i], access);
+      }
+
+      auto layouts = pickLayouts(groups);
+      auto ranges = toRanges(subresources, layout);
+      auto current = ImageLayout::Undefined;
+      for (size_t g = 0; g < groups.size(); ++g) {
+        for (auto member : groups[g].members)
+          plan.m_layouts.emplace(
+              std::pair{accesses[member].action, accesses[member].index},
+              layouts[g]);
+        if (layouts[g] == current)
+          continue;
+        auto *first = accesses[groups[g].members.front()].action;
+        for (auto member : groups[g].members)
+          if (positions.at(accesses[member].action) < positions.at(first))
+            first = accesses[member].action;
+        for (auto &range : ranges)
+          transitions.emplace_back(
+              positions.at(first),
+              LayoutTransition{first, resource, range, current, layouts[g]});
+        current = layouts[g];
+      }
+    }
+  }
+
+  std::ranges::stable_sort(transitions, {}, [](auto &t) { return t.first; });
+  for (auto &&[position, transition] : transitions)
+    plan.m_transitions.push_back(transition);
+  return plan;
+}
+
+} // namespace rgc
@@ -0,0 +1,243 @@
+#include <algorithm>
+#include <map>
+#include <numeric>
+
+#include "rgc/Dependencies.hpp"
+#include "rgc/Partitioning.hpp"
+#include "rgc/Resolution.hpp"
+#include "rgc/ResourceIndex.hpp"
+#include "rgc/Types.hpp"
+
+namespace rgc {
+
+namespace {
+
+/// Read of a resource version by a RealAction of another resource.
+struct Read {
+  size_t resource;
+  RealAction *reader;
+  size_t readerResource;
+};
+
+class Units {
+public:
+  explicit Units(size_t count) : m_parent(count) {
+    std::iota(m_parent.begin(), m_parent.end(), size_t{0});
+  }
+
+  size_t find(size_t i) {
+    while (m_parent[i] != i)
+      i = m_parent[i] = m_parent[m_parent[i]];
+    return i;
+  }
+
+  void unite(size_t a, size_t b) { m_parent[find(a)] = find(b); }
+
+private:
+  std::vector<size_t> m_parent;
+};
+
+} // namespace
+
+PartitionResult partitionGraph(Graph &graph, const ActionCost &cost,
+                               const PartitionOptions &options) {
+  assert(options.devices != 0 && "at least one device is required");
+  auto result = PartitionResult{};
+  result.loads.assign(options.devices, 0.0);
+  std::unordered_map<const Action *, size_t> positions;
+  for (auto *action : graph)
+    positions.emplace(action, positions.size());
+
+  auto index = ResourceIndex{graph};
+  auto resources = std::vector<Allocation *>(index.resources().begin(),
+                                             index.resources().end());
+  std::ranges::sort(resources, {}, [&](auto *r) { return positions.at(r); });
+  std::unordered_map<const Allocation *, size_t> ids;
+  for (auto *resource : resources)
+    ids.emplace(resource, ids.size());
+
+  // Resources that must share a device and direct reads that may cross
+  auto units = Units{resources.size()};
+  std::vector<Read> reads;
+  for (size_t r = 0; r < resources.size(); ++r) {
+    for (auto *reader : index.readers(resources[r])) {
+      auto *readerResource = index.resourceOf(reader);
+      if (!readerResource)
+        continue;
+      auto w = ids.at(readerResource);
+      auto *realAction = dynamic_cast<RealAction *>(reader);
+      if (realAction && index.resourceOf(realAction->getUse()) == resources[r])
+        reads.push_back({r, realAction, w});
+      else
+        units.unite(r, w);
+    }
+  }
+
+  std::vector<size_t> unitOf(resources.size());
+  std::map<size_t, size_t> unitIds;
+  for (size_t r = 0; r < resources.size(); ++r)
+    unitOf[r] = unitIds.emplace(units.find(r), unitIds.size()).first->second;
+  auto unitCount = unitIds.size();
+
+  std::vector<double> unitLoads(unitCount, 0.0);
+  for (size_t r = 0; r < resources.size(); ++r) {
+    auto &load = unitLoads[unitOf[r]];
+    load += cost(resources[r]);
+    for (auto *version : index.chain(resources[r]))
+      load += cost(version);
+    if (auto *terminator = index.terminator(resources[r]))
+      load += cost(terminator);
+  }
+
+  // Traffic between units
+  std::vector<std::map<size_t, double>> traffic(unitCount);
+  for (auto &read : reads) {
+    auto u = unitOf[read.resource];
+    auto w = unitOf[read.readerResource];
+    if (u == w)
+      continue;
+    auto weight = byteSize(read.reader->getUse()->type(), options.resolved) *
+                  options.byteCost;
+    traffic[u][w] += weight;
+    traffic[w][u] += weight;
+  }
+
+  std::vector<unsigned> deviceOf(unitCount, PartitionResult::AnyDevice);
+  auto &loads = result.loads;
+  auto capacity = (1.0 + options.imbalance) *
+                  std::accumulate(unitLoads.begin(), unitLoads.end(), 0.0) /
+                  options.devices;
+  auto cutCost = [&](size_t u, unsigned device) {
+    double total = 0;
+    for (auto &&[w, weight] : traffic[u])
+      if (deviceOf[w] != PartitionResult::AnyDevice && deviceOf[w] != device)
+        total += weight;
+    return total;
+  };
+
+  // Greedy placement, heaviest units first
+  std::vector<size_t> order(unitCount);
+  std::iota(order.begin(), order.end(), size_t{0});
+  std::ranges::stable_sort(order, std::greater{},
+                           [&](size_t u) { return unitLoads[u]; });
+  for (auto u : order) {
+    auto best = PartitionResult::AnyDevice;
+    for (unsigned d = 0; d < options.devices; ++d) {
+      if (loads[d] + unitLoads[u] > capacity)
+        continue;
+      if (best == PartitionResult::AnyDevice ||
+          cutCost(u, d) < cutCost(u, best) ||
+          (cutCost(u, d) == cutCost(u, best) && loads[d] < loads[best]))
+        best = d;
+    }
+    if (best == PartitionResult::AnyDevice)
+      best = std::ranges::min_element(loads) - loads.begin();
+    deviceOf[u] = best;
+    loads[best] += unitLoads[u];
+  }
+
+  // Single unit moves that reduce traffic within capacity or that improve
+  // balance without increasing traffic
+  for (unsigned pass = 0; pass < options.refinementPasses; ++pass) {
+    bool moved = false;
+    for (size_t u = 0; u < unitCount; ++u) {
+      auto from = deviceOf[u];
+      for (unsigned to = 0; to < options.devices; ++to) {
+        if (to == from)
+          continue;
+        auto gain = cutCost(u, from) - cutCost(u, to);
+        auto balances = loads[to] + unitLoads[u] < loads[from];
+        auto fits = loads[to] + unitLoads[u] <= capacity;
+        if ((gain > 0 && fits) || (gain == 0 && balances)) {
+          loads[from] -= unitLoads[u];
+          loads[to] += unitLoads[u];
+          deviceOf[u] = from = to;
+          moved = true;
+        }
+      }
+    }
+    if (!moved)
+      break;
+  }
+
+  for (size_t r = 0; r < resources.size(); ++r) {
+    auto device = deviceOf[unitOf[r]];
+    result.devices.emplace(resources[r], device);
+    for (auto *version : index.chain(resources[r]))
+      result.devices.emplace(version, device);
+    if (auto *terminator = index.terminator(resources[r]))
+      result.devices.emplace(terminator, device);
+  }
+
+  // Copies of versions read on other devices, one per version and device
+  std::map<std::pair<size_t, unsigned>, std::vector<RealAction *>> cut;
+  for (auto &read : reads) {
+    auto from = result.device(resources[read.resource]);
+    auto to = result.device(read.reader);
+    if (from == to)
+      continue;
+    auto version = positions.at(static_cast<Action *>(read.reader->getUse()));
+    cut[{version, to}].push_back(read.reader);
+  }
+  for (auto &&[key, readers] : cut) {
+    std::ranges::sort(readers, {}, [&](auto *r) { return positions.at(r); });
+    auto *source = readers.front()->getUse();
+    auto *sourceAction = static_cast<Action *>(source);
+    auto *copy = new Allocation{source->type()};
+    auto *transfer = new DeviceTransfer{
+        copy, source, result.device(sourceAction), key.second};
+    auto *terminator = new Terminator{graph.types(), transfer};
+    graph.insertBefore(copy, readers.front());
+    graph.insertBefore(transfer, readers.front());
+    graph.insertAfter(terminator, readers.back());
+    for (auto *reader : readers)
+      reader->replaceUse(1u, transfer);
+    for (auto *action : std::initializer_list<Action *>{copy, transfer,
+                                                        terminator})
+      result.devices.emplace(action, key.second);
+    result.transfers.push_back(transfer);
+    result.transferredBytes += byteSize(source->type(), options.resolved);
+  }
+  return result;
+}
+
+SimulationResult simulate(Graph &graph, const PartitionResult &partition,
+                          const ActionCost &cost, double byteCost,
+                          const ResolvedGraph *resolved) {
+  auto devices = partition.loads.size();
+  auto result = SimulationResult{};
+  result.busy.assign(devices, 0.0);
+  std::vector<double> computeFree(devices, 0.0);
+  std::vector<double> copyFree(devices, 0.0);
+
+  auto index = ResourceIndex{graph};
+  auto dependencies = DependencyGraph{graph, index};
+  std::unordered_map<const Value *, double> finish;
+  for (auto *action : graph) {
+    double ready = 0;
+    for (auto *dependency : dependencies.dependencies(action))
+      ready = std::max(ready, finish.at(dependency));
+    for (auto *use : action->uses())
+      if (auto found = finish.find(use); found != finish.end())
+        ready = std::max(ready, found->second);
+
+    auto device = partition.device(action);
+    auto end = ready;
+    if (auto *transfer = dynamic_cast<DeviceTransfer *>(action)) {
+      auto start = std::max(ready, copyFree[transfer->to()]);
+      end = start + byteSize(transfer->type(), resolved) * byteCost;
+      copyFree[transfer->to()] = end;
+    } else if (device != PartitionResult::AnyDevice) {
+      auto duration = cost(action);
+      auto start = std::max(ready, computeFree[device]);
+      end = start + duration;
+      computeFree[device] = end;
+      result.busy[device] += duration;
+    }
+    finish.emplace(action, end);
+    result.makespan = std::max(result.makespan, end);
+  }
+  return result;
+}
+
+} // namespace rgc
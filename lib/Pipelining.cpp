@@ -0,0 +1,163 @@
+#include <algorithm>
+#include <optional>
+
+#include "rgc/Pipelining.hpp"
+#include "rgc/ResourceIndex.hpp"
+#include "rgc/Suballocation.hpp"
+#include "rgc/Types.hpp"
+
+namespace rgc {
+
+namespace {
+
+/// Interns copy of a graph's type into pool, so that it outlives the graph.
+/// Returns nullptr for types of classes unknown to the library.
+Type *internCopy(TypePool &pool, const Type *type) {
+  if (auto *buffer = dynamic_cast<const BufferType *>(type))
+    return pool.get<BufferType>(buffer->ownerType(), buffer->elementSize(),
+                                buffer->extent());
+  if (auto *tied = dynamic_cast<const TiedToScreenBufferImage *>(type))
+    return pool.get<TiedToScreenBufferImage>(tied->pixelFormat(),
+                                             tied->getSwapChainID());
+  if (auto *screen = dynamic_cast<const ScreenBufferImage *>(type))
+    return pool.get<ScreenBufferImage>(screen->getSwapChainID());
+  if (auto *image = dynamic_cast<const ImageType *>(type))
+    return pool.get<ImageType>(image->imageKind(), image->pixelFormat(),
+                               image->extentType(), image->mipLevels(),
+                               image->extents(), image->arrayLayers());
+  if (dynamic_cast<const NullType *>(type))
+    return pool.get<NullType>();
+  return nullptr;
+}
+
+bool isHostOwned(const Type *type) {
+  auto *scalar = dynamic_cast<const ScalarType *>(type);
+  return scalar && scalar->ownerType() == ScalarType::OwnerType::Host;
+}
+
+} // namespace
+
+FramePipeline::FramePipeline(unsigned framesInFlight, unsigned maxIdleFrames)
+    : m_framesInFlight(framesInFlight), m_maxIdleFrames(maxIdleFrames) {
+  assert(m_framesInFlight != 0 && "at least one frame must be in flight");
+}
+
+FramePlan FramePipeline::beginFrame(Graph &graph) {
+  auto plan = FramePlan{};
+  plan.frame = m_frame;
+  // Frame is in flight until framesInFlight frames were begun after it
+  std::erase_if(m_retired, [&](auto &slot) {
+    if (slot.lastUse + m_framesInFlight > m_frame)
+      return false;
+    plan.released.push_back(slot.resource);
+    return true;
+  });
+  auto index = ResourceIndex{graph};
+
+  // Persistent resources: collect usage first, as it defines ring sizes
+  struct Usage {
+    bool written = false;
+    /// Copy bound to Current imports of this frame
+    std::optional<size_t> current;
+  };
+  std::unordered_map<unsigned, Usage> usages;
+  std::vector<Import *> imports;
+  for (auto *action : graph) {
+    auto *import = dynamic_cast<Import *>(action);
+    if (!import)
+      continue;
+    auto &persistent = m_persistent.at(import->resourceID());
+    assert(persistent.type->equal(import->type()) &&
+           "import type does not match persistent resource");
+    auto written = !index.chain(import).empty();
+    usages[import->resourceID()].written |= written;
+    if (import->access() == Import::Access::History) {
+      assert(!written && "history can only be read");
+      persistent.history = true;
+    } else if (written && isHostOwned(persistent.type))
+      persistent.hostWritten = true;
+    imports.push_back(import);
+  }
+  for (auto *import : imports) {
+    auto &persistent = m_persistent.at(import->resourceID());
+    size_t required = std::max<size_t>(
+        persistent.hostWritten ? m_framesInFlight : 1u,
+        persistent.history ? 2u : 1u);
+    // Ring grows at its end, so copies written by earlier frames keep
+    // their indices
+    while (persistent.copies.size() < required)
+      persistent.copies.push_back(m_create(persistent.type, plan));
+    auto copies = persistent.copies.size();
+
+    // Frame writing the resource moves on to the copy after the last
+    // written one, a frame only reading it reads the last written one
+    auto &usage = usages.at(import->resourceID());
+    if (!usage.current) {
+      auto &last = persistent.written;
+      usage.current = !last          ? 0u
+                      : usage.written ? (*last + 1u) % copies
+                                      : *last;
+    }
+    auto copy = *usage.current;
+    if (import->access() == Import::Access::History)
+      copy = persistent.written ? *persistent.written
+                                : (copy + copies - 1u) % copies;
+    plan.bindings.emplace(import, persistent.copies[copy]);
+  }
+  for (auto &&[resourceID, usage] : usages)
+    if (usage.written)
+      m_persistent[resourceID].written = usage.current;
+
+  // Transient resources
+  for (auto *action : graph) {
+    if (action->actionKind() != Action::Kind::Allocation ||
+        dynamic_cast<Import *>(action) || dynamic_cast<SubAllocation *>(action))
+      continue;
+    auto *allocation = static_cast<Allocation *>(action);
+    auto *image = dynamic_cast<const ImageType *>(allocation->type());
+    if (image && image->imageKind() == ImageType::ImageKind::ScreenBuffer)
+      continue;
+    auto *type = internCopy(m_types, allocation->type());
+    if (!type || !index.terminator(allocation)) {
+      // Resource that is not terminated may be used until the end of the
+      // frame, so it gets one of its own. Type that can't outlive the graph
+      // is not reported on release
+      auto resource = m_create(type ? type : allocation->type(), plan);
+      m_retired.push_back({{resource.id, type}, m_frame});
+      plan.bindings.emplace(allocation, resource);
+      continue;
+    }
+    size_t lag = isHostOwned(type) ? m_framesInFlight : 1u;
+    auto &slots = m_transients[type];
+    auto free = std::ranges::find_if(
+        slots, [&](auto &slot) { return slot.lastUse + lag <= m_frame; });
+    if (free == slots.end()) {
+      slots.push_back({m_create(type, plan), m_frame});
+      free = std::prev(slots.end());
+    }
+    free->lastUse = m_frame;
+    plan.bindings.emplace(allocation, free->resource);
+  }
+
+  // Idle slot may still be used by a frame in flight
+  size_t maxIdle = std::max(m_maxIdleFrames, m_framesInFlight - 1u);
+  for (auto &&[type, slots] : m_transients) {
+    std::erase_if(slots, [&](auto &slot) {
+      if (m_frame - slot.lastUse <= maxIdle)
+        return false;
+      plan.released.push_back(slot.resource);
+      return true;
+    });
+  }
+
+  ++m_frame;
+  return plan;
+}
+
+PhysicalResource FramePipeline::m_create(const Type *type, FramePlan &plan) {
+  auto resource = PhysicalResource{m_nextID++, type};
+  plan.created.push_back(resource);
+  return resource;
+}
+
+} // namespace rgc
@@ -0,0 +1,206 @@
+#include <algorithm>
+#include <array>
+#include <set>
+#include <tuple>
+#include <unordered_map>
+
+#include "rgc/Dependencies.hpp"
+#include "rgc/Pipelining.hpp"
+#include "rgc/Reordering.hpp"
+#include "rgc/Resolution.hpp"
+#include "rgc/ResourceIndex.hpp"
+#include "rgc/Suballocation.hpp"
+#include "rgc/Types.hpp"
+
+namespace rgc {
+
+namespace {
+
+/// @return root Allocation of the resource value is a version of.
+Allocation *rootOf(Value *value) {
+  while (auto *action = dynamic_cast<Action *>(value)) {
+    switch (action->actionKind()) {
+    case Action::Kind::Allocation:
+      return static_cast<Allocation *>(action);
+    case Action::Kind::RealAction:
+      value = static_cast<RealAction *>(action)->getUseDef();
+      break;
+    default:
+      return nullptr;
+    }
+  }
+  return nullptr;
+}
+
+struct Node {
+  size_t level = 0;
+  unsigned pending = 0;
+  std::vector<size_t> dependents;
+  Allocation *resource = nullptr;
+};
+
+// Scheduling priority classes
+enum Class { Frees, Neutral, Allocates };
+
+Class classOf(const Action *action) {
+  switch (action->actionKind()) {
+  case Action::Kind::Terminator:
+    return Frees;
+  case Action::Kind::Allocation:
+    return Allocates;
+  default:
+    return Neutral;
+  }
+}
+
+} // namespace
+
+size_t ownedBytes(const Allocation *allocation,
+                  const ResolvedGraph *resolved) {
+  if (dynamic_cast<const SubAllocation *>(allocation) ||
+      dynamic_cast<const Import *>(allocation))
+    return 0;
+  auto *image = dynamic_cast<const ImageType *>(allocation->type());
+  if (image && image->imageKind() == ImageType::ImageKind::ScreenBuffer)
+    return 0;
+  return byteSize(allocation->type(), resolved);
+}
+
+size_t peakMemory(const Graph &graph, const ResolvedGraph *resolved) {
+  size_t live = 0;
+  size_t peak = 0;
+  for (auto *action : graph) {
+    switch (action->actionKind()) {
+    case Action::Kind::Allocation:
+      live += ownedBytes(static_cast<Allocation *>(action), resolved);
+      peak = std::max(peak, live);
+      break;
+    case Action::Kind::Terminator:
+      if (auto *root = rootOf(action->uses()[0]); root && graph.contains(root))
+        live -= ownedBytes(root, resolved);
+      break;
+    default:
+      break;
+    }
+  }
+  return peak;
+}
+
+ReorderReport reorderForMemory(Graph &graph, const ReorderOptions &options) {
+  auto report = ReorderReport{peakMemory(graph, options.resolved)};
+  std::vector<Action *> actions(graph.begin(), graph.end());
+  std::unordered_map<const Value *, size_t> positions;
+  for (size_t i = 0; i < actions.size(); ++i)
+    positions.emplace(actions[i], i);
+
+  // Use-def edges and execution dependencies
+  std::vector<Node> nodes(actions.size());
+  {
+    auto index = ResourceIndex{graph};
+    auto dependencies = DependencyGraph{graph, index};
+    std::vector<size_t> deps;
+    for (size_t i = 0; i < actions.size(); ++i) {
+      auto *action = actions[i];
+      deps.clear();
+      for (auto *use : action->uses())
+        if (auto found = positions.find(use); found != positions.end())
+          deps.push_back(found->second);
+      for (auto *dep : dependencies.dependencies(action))
+        deps.push_back(positions.at(dep));
+      std::ranges::sort(deps);
+      deps.erase(std::unique(deps.begin(), deps.end()), deps.end());
+      for (auto dep : deps) {
+        ++nodes[i].pending;
+        nodes[dep].dependents.push_back(i);
+      }
+      if (action->actionKind() == Action::Kind::Allocation)
+        nodes[i].resource = static_cast<Allocation *>(action);
+      else if (action->actionKind() != Action::Kind::Composition)
+        nodes[i].resource = index.resourceOf(action->uses()[0]);
+    }
+  }
+
+  // Wave level of every action is the length of the longest dependency
+  // path leading to it
+  {
+    std::vector<unsigned> pending(nodes.size());
+    std::vector<size_t> queue;
+    for (size_t i = 0; i < nodes.size(); ++i)
+      if (!(pending[i] = nodes[i].pending))
+        queue.push_back(i);
+    for (size_t q = 0; q < queue.size(); ++q) {
+      auto &node = nodes[queue[q]];
+      for (auto dependent : node.dependents) {
+        auto &next = nodes[dependent];
+        next.level = std::max(next.level, node.level + 1u);
+        if (!--pending[dependent])
+          queue.push_back(dependent);
+      }
+    }
+    assert(queue.size() == nodes.size() && "cyclic dependency");
+  }
+
+  // Ready actions ordered by wave level, then by owned bytes (Allocations
+  // only), then by original position
+  using Key = std::tuple<size_t, size_t, size_t>;
+  std::array<std::set<Key>, 3> ready;
+  std::unordered_map<Allocation *, std::set<Key>> readyByResource;
+  auto makeReady = [&](size_t i) {
+    auto cls = classOf(actions[i]);
+    auto bytes = cls == Allocates
+                     ? ownedBytes(static_cast<Allocation *>(actions[i]),
+                                  options.resolved)
+                     : 0u;
+    auto key = Key{nodes[i].level, bytes, i};
+    ready[cls].insert(key);
+    if (cls == Neutral && nodes[i].resource)
+      readyByResource[nodes[i].resource].insert(key);
+  };
+  for (size_t i = 0; i < nodes.size(); ++i)
+    if (!nodes[i].pending)
+      makeReady(i);
+
+  std::vector<Action *> order;
+  order.reserve(actions.size());
+  Allocation *lastResource = nullptr;
+  while (order.size() < actions.size()) {
+    auto minLevel = ~size_t{0};
+    for (auto &set : ready)
+      if (!set.empty())
+        minLevel = std::min(minLevel, std::get<0>(*set.begin()));
+    auto eligible = [&](const std::set<Key> &set) {
+      return !set.empty() &&
+             std::get<0>(*set.begin()) - minLevel <= options.maxWaveSkew;
+    };
+
+    Key key;
+    if (eligible(ready[Frees]))
+      key = *ready[Frees].begin();
+    else if (auto found = readyByResource.find(lastResource);
+             found != readyByResource.end() && eligible(found->second))
+      key = *found->second.begin();
+    else if (eligible(ready[Neutral]))
+      key = *ready[Neutral].begin();
+    else
+      key = *ready[Allocates].begin();
+
+    auto i = std::get<2>(key);
+    auto cls = classOf(actions[i]);
+    ready[cls].erase(key);
+    if (cls == Neutral && nodes[i].resource)
+      readyByResource[nodes[i].resource].erase(key);
+    order.push_back(actions[i]);
+    if (nodes[i].resource)
+      lastResource = nodes[i].resource;
+    for (auto dependent : nodes[i].dependents)
+      if (!--nodes[dependent].pending)
+        makeReady(dependent);
+  }
+
+  for (auto *action : order)
+    graph.moveBefore(action, nullptr);
+  report.peakAfter = peakMemory(graph, options.resolved);
+  return report;
+}
+
+} // namespace rgc
@@ -0,0 +1,40 @@
+#include "rgc/Resolution.hpp"
+
+namespace rgc {
+
+namespace {
+
+std::optional<unsigned> swapChainOf(const ImageType *image) {
+  if (auto *screen = dynamic_cast<const ScreenBufferImage *>(image))
+    return screen->getSwapChainID();
+  if (auto *tied = dynamic_cast<const TiedToScreenBufferImage *>(image))
+    return tied->getSwapChainID();
+  return std::nullopt;
+}
+
+} // namespace
+
+ResolvedGraph::ResolvedGraph(const Graph &graph,
+                             const ResolutionSet &resolutions)
+    : m_graph(graph) {
+  for (auto *type : graph.types()) {
+    auto *image = dynamic_cast<ImageType *>(type);
+    if (!image)
+      continue;
+    auto swapChainID = swapChainOf(image);
+    if (!swapChainID)
+      continue;
+    auto *extents = resolutions.extents(*swapChainID);
+    if (!extents) {
+      m_complete = false;
+      continue;
+    }
+    m_resolved.emplace(type, m_types.get<ImageType>(
+                                 image->imageKind(), image->pixelFormat(),
+                                 ImageType::ExtentType::T2D,
+                                 image->mipLevels(), *extents,
+                                 image->arrayLayers()));
+  }
+}
+
+} // namespace rgc
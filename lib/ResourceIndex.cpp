@@ -0,0 +1,262 @@
+#include <unordered_set>
+
+#include "rgc/ResourceIndex.hpp"
+
+namespace rgc {
+
+namespace {
+
+/// Calls f for every action reading through composition, descending into
+/// nested compositions.
+template <typename F>
+void forEachComposedReader(const Graph &graph, Action *composition, F &&f) {
+  for (auto &use : composition->users()) {
+    auto *user = use.user();
+    if (!graph.contains(user))
+      continue;
+    if (user->actionKind() == Action::Kind::Composition)
+      forEachComposedReader(graph, user, f);
+    else
+      f(user);
+  }
+}
+
+} // namespace
+
+ResourceIndex::ResourceIndex(Graph &graph) : m_graph(graph) {
+  for (auto *action : m_graph)
+    if (action->actionKind() == Action::Kind::Allocation)
+      m_resources[static_cast<Allocation *>(action)].stale = true;
+  m_graph.addObserver(this);
+}
+
+ResourceIndex::~ResourceIndex() { m_graph.removeObserver(this); }
+
+Allocation *ResourceIndex::resourceOf(Value *value) {
+  auto *action = dynamic_cast<Action *>(value);
+  while (action) {
+    switch (action->actionKind()) {
+    case Action::Kind::Allocation:
+      return static_cast<Allocation *>(action);
+    case Action::Kind::Composition:
+      return nullptr;
+    case Action::Kind::RealAction:
+    case Action::Kind::Terminator: {
+      if (auto found = m_owners.find(action); found != m_owners.end()) {
+        auto record = m_resources.find(found->second);
+        if (record != m_resources.end() && !record->second.stale)
+          return found->second;
+      }
+      action = dynamic_cast<Action *>(action->uses()[0]);
+      break;
+    }
+    }
+  }
+  return nullptr;
+}
+
+std::span<RealAction *const> ResourceIndex::chain(Allocation *resource) {
+  if (auto *record = m_record(resource))
+    return record->chain;
+  return {};
+}
+
+Terminator *ResourceIndex::terminator(Allocation *resource) {
+  if (auto *record = m_record(resource))
+    return record->terminator;
+  return nullptr;
+}
+
+std::span<Action *const> ResourceIndex::readers(Allocation *resource) {
+  if (auto *record = m_record(resource))
+    return record->readers;
+  return {};
+}
+
+Value *ResourceIndex::lastVersion(Allocation *resource) {
+  auto versions = chain(resource);
+  if (versions.empty())
+    return resource;
+  return versions.back();
+}
+
+void ResourceIndex::actionInserted(Action *action) {
+  switch (action->actionKind()) {
+  case Action::Kind::Allocation: {
+    auto *allocation = static_cast<Allocation *>(action);
+    // Allocation may be inserted after its users
+    m_resources[allocation].stale = !allocation->unused();
+    if (allocation->allocationKind() == Allocation::Kind::Dynamic)
+      m_read(allocation, allocation->uses()[0]);
+    return;
+  }
+  case Action::Kind::Composition:
+    if (!action->unused())
+      for (auto *use : action->uses())
+        m_touch(use);
+    return;
+  case Action::Kind::RealAction:
+  case Action::Kind::Terminator: {
+    // Fast path: action continues the tail of an up-to-date chain
+    auto *prev = action->uses()[0];
+    auto *resource = resourceOf(prev);
+    auto found = m_resources.find(resource);
+    auto *record = found == m_resources.end() ? nullptr : &found->second;
+    bool isTail = record && !record->stale && action->unused() &&
+                  !record->terminator && lastVersion(resource) == prev;
+    if (!isTail)
+      m_touch(prev);
+    else if (action->actionKind() == Action::Kind::Terminator)
+      record->terminator = static_cast<Terminator *>(action);
+    else
+      record->chain.push_back(static_cast<RealAction *>(action));
+    if (isTail)
+      m_owners[action] = resource;
+
+    if (action->actionKind() == Action::Kind::RealAction)
+      m_read(action, static_cast<RealAction *>(action)->getUse());
+    return;
+  }
+  }
+}
+
+void ResourceIndex::actionErased(Action *action) {
+  if (action->actionKind() == Action::Kind::Allocation) {
+    auto found = m_resources.find(static_cast<Allocation *>(action));
+    if (found != m_resources.end()) {
+      m_rebuild(found->first, found->second);
+      for (auto *version : found->second.chain)
+        m_owners.erase(version);
+      if (found->second.terminator)
+        m_owners.erase(found->second.terminator);
+      m_resources.erase(found);
+    }
+  }
+  for (auto *use : action->uses())
+    m_touch(use);
+  m_owners.erase(action);
+}
+
+void ResourceIndex::useReplaced(Action * /*user*/, unsigned /*index*/,
+                                Value *from, Value *to) {
+  m_touch(from);
+  m_touch(to);
+}
+
+ResourceIndex::Record *ResourceIndex::m_record(Allocation *resource) {
+  auto found = m_resources.find(resource);
+  if (found == m_resources.end())
+    return nullptr;
+  if (found->second.stale)
+    m_rebuild(resource, found->second);
+  return &found->second;
+}
+
+void ResourceIndex::m_rebuild(Allocation *resource, Record &record) {
+  // Forget about old versions, unless they already belong to other resource
+  auto forget = [&](Action *action) {
+    auto found = m_owners.find(action);
+    if (found != m_owners.end() && found->second == resource)
+      m_owners.erase(found);
+  };
+  for (auto *version : record.chain)
+    forget(version);
+  if (record.terminator)
+    forget(record.terminator);
+  record = Record{};
+
+  std::unordered_set<Action *> seen;
+  auto addReader = [&](Action *reader) {
+    if (seen.insert(reader).second)
+      record.readers.push_back(reader);
+  };
+
+  std::vector<Value *> versions{resource};
+  for (size_t i = 0; i < versions.size(); ++i) {
+    for (auto &use : versions[i]->users()) {
+      auto *user = use.user();
+      if (!m_graph.contains(user))
+        continue;
+      switch (user->actionKind()) {
+      case Action::Kind::RealAction:
+        if (use.index() == 0) {
+          auto *version = static_cast<RealAction *>(user);
+          record.chain.push_back(version);
+          versions.push_back(version);
+          m_owners[version] = resource;
+        } else
+          addReader(user);
+        break;
+      case Action::Kind::Terminator:
+        record.terminator = static_cast<Terminator *>(user);
+        m_owners[user] = resource;
+        break;
+      case Action::Kind::Composition:
+        forEachComposedReader(m_graph, user, addReader);
+        break;
+      case Action::Kind::Allocation:
+        addReader(user);
+        break;
+      }
+    }
+  }
+}
+
+void ResourceIndex::m_touch(Value *value) {
+  auto *action = dynamic_cast<Action *>(value);
+  if (!action)
+    return;
+  if (action->actionKind() == Action::Kind::Composition) {
+    for (auto *use : action->uses())
+      m_touch(use);
+    return;
+  }
+  // Walk up the chain until resource is known. Stale owner is good enough
+  // here: if it is outdated, the actual resource is stale as well.
+  while (action->actionKind() != Action::Kind::Allocation) {
+    if (auto found = m_owners.find(action); found != m_owners.end()) {
+      if (auto record = m_resources.find(found->second);
+          record != m_resources.end())
+        record->second.stale = true;
+      return;
+    }
+    action = dynamic_cast<Action *>(action->uses()[0]);
+    if (!action || action->actionKind() == Action::Kind::Composition)
+      return;
+  }
+  if (auto found = m_resources.find(static_cast<Allocation *>(action));
+      found != m_resources.end())
+    found->second.stale = true;
+}
+
+void ResourceIndex::m_read(Action *reader, Value *value) {
+  auto *action = dynamic_cast<Action *>(value);
+  if (!action || !m_graph.contains(action))
+    return;
+  Allocation *resource = nullptr;
+  switch (action->actionKind()) {
+  case Action::Kind::Composition:
+    for (auto *use : action->uses())
+      m_read(reader, use);
+    return;
+  case Action::Kind::Terminator:
+    return;
+  case Action::Kind::Allocation:
+    resource = static_cast<Allocation *>(action);
+    break;
+  case Action::Kind::RealAction:
+    if (auto found = m_owners.find(action); found != m_owners.end())
+      resource = found->second;
+    break;
+  }
+  auto found = m_resources.find(resource);
+  if (found == m_resources.end() || found->second.stale) {
+    m_touch(action);
+    return;
+  }
+  auto &record = found->second;
+  if (record.readers.empty() || record.readers.back() != reader)
+    record.readers.push_back(reader);
+}
+
+} // namespace rgc
@@ -0,0 +1,128 @@
+#include <algorithm>
+#include <map>
+#include <numeric>
+#include <unordered_map>
+
+#include "rgc/ResourceIndex.hpp"
+#include "rgc/Suballocation.hpp"
+#include "rgc/Types.hpp"
+
+namespace rgc {
+
+namespace {
+
+size_t alignmentOf(const BufferType *type,
+                   const SuballocationOptions &options) {
+  // Offset must be a multiple of the stride, which needn't be a power of two
+  return std::lcm(type->elementSize(), options.minAlignment);
+}
+
+size_t alignUp(size_t value, size_t alignment) {
+  return (value + alignment - 1u) / alignment * alignment;
+}
+
+struct Member {
+  Allocation *allocation;
+  size_t offset;
+  // Last action in the graph touching the buffer and its position
+  Action *lastTouch;
+  size_t lastPosition;
+};
+
+struct Block {
+  std::vector<Member> members;
+  size_t size = 0;
+  // Least common multiple of alignments of members
+  size_t alignment = 1;
+};
+
+} // namespace
+
+SuballocationResult suballocateBuffers(Graph &graph,
+                                       const SuballocationOptions &options) {
+  auto index = ResourceIndex{graph};
+  std::unordered_map<Action *, size_t> positions;
+  for (auto *action : graph)
+    positions.emplace(action, positions.size());
+
+  auto lastTouch = [&](Allocation *allocation) {
+    Action *last = allocation;
+    auto consider = [&](Action *action) {
+      if (positions.at(action) > positions.at(last))
+        last = action;
+    };
+    for (auto *version : index.chain(allocation))
+      consider(version);
+    for (auto *reader : index.readers(allocation))
+      consider(reader);
+    if (auto *terminator = index.terminator(allocation))
+      consider(terminator);
+    return last;
+  };
+
+  std::map<ScalarType::OwnerType, std::vector<Block>> groups;
+  for (auto *action : graph) {
+    if (action->actionKind() != Action::Kind::Allocation)
+      continue;
+    auto *allocation = static_cast<Allocation *>(action);
+    if (allocation->allocationKind() != Allocation::Kind::Static)
+      continue;
+    auto *buffer = dynamic_cast<const BufferType *>(allocation->type());
+    if (!buffer || buffer->hasDynamicExtents() ||
+        buffer->byteSize() > options.maxBufferSize)
+      continue;
+
+    auto alignment = alignmentOf(buffer, options);
+    if (alignment > options.maxAlignment)
+      continue;
+
+    auto &blocks = groups[buffer->ownerType()];
+    if (blocks.empty() ||
+        (!blocks.back().members.empty() &&
+         (alignUp(blocks.back().size, alignment) + buffer->byteSize() >
+              options.blockSize ||
+          std::lcm(blocks.back().alignment, alignment) >
+              options.maxAlignment)))
+      blocks.emplace_back();
+    auto &block = blocks.back();
+    auto offset = alignUp(block.size, alignment);
+    auto *last = lastTouch(allocation);
+    block.members.push_back({allocation, offset, last, positions.at(last)});
+    block.size = offset + buffer->byteSize();
+    block.alignment = std::lcm(block.alignment, alignment);
+  }
+
+  SuballocationResult result;
+  for (auto &&[owner, blocks] : groups) {
+    for (auto &block : blocks) {
+      // Nothing to gain from a block with a single buffer
+      if (block.members.size() < 2)
+        continue;
+      // Element size of the block carries its alignment
+      auto *blockAllocation = new Allocation{graph.getType<BufferType>(
+          owner, block.alignment,
+          alignUp(block.size, block.alignment) / block.alignment)};
+      graph.insertBefore(blockAllocation, block.members.front().allocation);
+
+      Action *last = nullptr;
+      size_t lastPosition = 0;
+      for (auto &member : block.members) {
+        auto *sub = new SubAllocation{member.allocation->type(),
+                                      blockAllocation, member.offset};
+        graph.insertBefore(sub, member.allocation);
+        if (!last || member.lastPosition >= lastPosition) {
+          last = member.lastTouch == member.allocation ? sub : member.lastTouch;
+          lastPosition = member.lastPosition;
+        }
+        member.allocation->replaceAllUsesWith(sub);
+        graph.erase(member.allocation);
+      }
+      graph.insertAfter(new Terminator{graph.types(), blockAllocation}, last);
+      result.blocks.push_back(blockAllocation);
+      result.suballocated += block.members.size();
+    }
+  }
+  return result;
+}
+
+} // namespace rgc
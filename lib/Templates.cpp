@@ -0,0 +1,90 @@
+#include <algorithm>
+#include <typeinfo>
+
+#include "rgc/Templates.hpp"
+
+namespace rgc {
+
+SubgraphTemplate::SubgraphTemplate(std::span<Action *const> actions,
+                                   std::span<Value *const> parameters)
+    : m_parameterCount(parameters.size()) {
+  std::unordered_map<const Value *, unsigned> slots;
+  for (unsigned i = 0; i < parameters.size(); ++i)
+    slots.emplace(parameters[i], i);
+  std::unordered_map<const Value *, Value *> placeholders;
+  auto placeholder = [&](Value *value) {
+    auto [found, inserted] = placeholders.emplace(value, nullptr);
+    if (inserted) {
+      auto *allocation = new Allocation{value->type()};
+      m_body.push_back(allocation);
+      found->second = allocation;
+    }
+    return found->second;
+  };
+#ifndef NDEBUG
+  auto captured = std::unordered_map<const Value *, unsigned>{};
+  for (unsigned i = 0; i < actions.size(); ++i)
+    captured.emplace(actions[i], i);
+#endif
+
+  std::vector<Value *> bodyOperands;
+  m_operandOffsets.push_back(0);
+  for (unsigned i = 0; i < actions.size(); ++i) {
+    auto *action = actions[i];
+    bodyOperands.clear();
+    for (auto *use : action->uses()) {
+      auto found = slots.find(use);
+      if (found == slots.end()) {
+        assert(!captured.contains(use) &&
+               "actions must be given in execution order");
+        m_operands.push_back({use, 0u});
+        bodyOperands.push_back(placeholder(use));
+        continue;
+      }
+      auto slot = found->second;
+      m_operands.push_back({nullptr, slot});
+      bodyOperands.push_back(slot < m_parameterCount
+                                 ? placeholder(use)
+                                 : m_prototypes[slot - m_parameterCount]);
+    }
+    m_operandOffsets.push_back(m_operands.size());
+    auto *prototype = action->clone(bodyOperands);
+    assert(typeid(*prototype) == typeid(*action) &&
+           "action class must override clone");
+    m_body.push_back(prototype);
+    m_prototypes.push_back(prototype);
+    slots.emplace(action, m_parameterCount + i);
+  }
+}
+
+ptrdiff_t SubgraphTemplate::indexOf(const Action *prototype) const {
+  auto found = std::ranges::find(m_prototypes, prototype);
+  return found == m_prototypes.end() ? -1 : found - m_prototypes.begin();
+}
+
+SubgraphInstance
+SubgraphTemplate::instantiate(Graph &graph, std::span<Value *const> arguments,
+                              Action *before) const {
+  assert(arguments.size() == m_parameterCount && "argument count mismatch");
+  auto instance = SubgraphInstance{};
+  instance.m_source = this;
+  instance.m_actions.reserve(m_prototypes.size());
+  std::vector<Value *> slots;
+  slots.reserve(m_parameterCount + m_prototypes.size());
+  slots.assign(arguments.begin(), arguments.end());
+  std::vector<Value *> operands;
+  for (size_t i = 0; i < m_prototypes.size(); ++i) {
+    operands.clear();
+    for (auto o = m_operandOffsets[i]; o < m_operandOffsets[i + 1]; ++o) {
+      auto &operand = m_operands[o];
+      operands.push_back(operand.shared ? operand.shared : slots[operand.slot]);
+    }
+    auto *action = m_prototypes[i]->clone(operands);
+    slots.push_back(action);
+    instance.m_actions.push_back(action);
+  }
+  graph.insertBefore(std::span<Action *const>{instance.m_actions}, before);
+  return instance;
+}
+
+} // namespace rgc
@@ -0,0 +1,748 @@
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <charconv>
+#include <cstring>
+#include <optional>
+#include <unordered_map>
+
+#include "rgc/Partitioning.hpp"
+#include "rgc/Pipelining.hpp"
+#include "rgc/Suballocation.hpp"
+#include "rgc/TextIR.hpp"
+#include "rgc/Transfer.hpp"
+#include "rgc/Types.hpp"
+
+namespace rgc {
+
+namespace {
+
+constexpr size_t BlockSize = 1u << 20u;
+
+constexpr std::string_view PixelFormatNames[] = {
+#define RDC_PIXEL_FORMAT(X) #X,
+#include "rgc/PixelFormat.inc"
+    "auto"};
+
+constexpr std::string_view ExtentTypeNames[] = {"1d", "2d", "3d", "auto"};
+
+constexpr std::string_view ImageKindNames[] = {"allocated", "screen_buffer",
+                                               "tied"};
+
+constexpr std::string_view OwnerNames[] = {"host", "device", "none"};
+
+constexpr std::string_view AccessNames[] = {"unknown",
+                                            "color_attachment",
+                                            "depth_stencil_attachment",
+                                            "sampled",
+                                            "storage",
+                                            "transfer_src",
+                                            "transfer_dst"};
+
+template <size_t N>
+std::optional<size_t> lookup(const std::string_view (&names)[N],
+                             std::string_view name) {
+  auto found = std::ranges::find(names, name);
+  if (found == std::end(names))
+    return std::nullopt;
+  return found - std::begin(names);
+}
+
+class Printer {
+public:
+  Printer(const Graph &graph, std::ostream &os) : m_graph(graph), m_os(os) {}
+
+  void print() {
+    for (auto *action : m_graph) {
+      m_action(action);
+      m_values.emplace(action, m_values.size());
+      if (m_out.size() >= BlockSize)
+        m_flush();
+    }
+    m_flush();
+  }
+
+private:
+  void m_flush() {
+    m_os.write(m_out.data(), m_out.size());
+    m_out.clear();
+  }
+
+  void m_number(std::uint64_t value) {
+    char digits[20];
+    auto end = std::to_chars(digits, digits + sizeof(digits), value).ptr;
+    m_out.append(digits, end);
+  }
+
+  void m_name(std::span<const std::string_view> names, size_t index) {
+    assert(index < names.size() && "unknown enumerator");
+    m_out += names[index];
+  }
+
+  void m_count(std::uint16_t count) {
+    if (count == SubresourceRange::All)
+      m_out += "all";
+    else
+      m_number(count);
+  }
+
+  /// Defines type if it was not used yet.
+  size_t m_type(const Type *type) {
+    auto [found, inserted] = m_types.emplace(type, m_types.size());
+    if (!inserted)
+      return found->second;
+
+    m_out += '!';
+    m_number(found->second);
+    m_out += " = ";
+    auto image = [&](const ImageType *image) {
+      m_name(PixelFormatNames, static_cast<size_t>(image->pixelFormat()));
+      m_out += ' ';
+      m_name(ExtentTypeNames, static_cast<size_t>(image->extentType()));
+      m_out += ' ';
+      auto extents = image->extents();
+      m_number(extents[0]);
+      m_out += 'x';
+      m_number(extents[1]);
+      m_out += 'x';
+      m_number(extents[2]);
+      m_out += " mips ";
+      m_number(image->mipLevels());
+      m_out += " layers ";
+      m_number(image->arrayLayers());
+    };
+    if (dynamic_cast<const NullType *>(type)) {
+      m_out += "null";
+    } else if (auto *screen = dynamic_cast<const ScreenBufferImage *>(type)) {
+      m_out += "screen_buffer ";
+      m_number(screen->getSwapChainID());
+    } else if (auto *tied =
+                   dynamic_cast<const TiedToScreenBufferImage *>(type)) {
+      m_out += "tied_image ";
+      m_name(PixelFormatNames, static_cast<size_t>(tied->pixelFormat()));
+      m_out += ' ';
+      m_number(tied->getSwapChainID());
+    } else if (auto *allocated =
+                   dynamic_cast<const AllocatedImageType *>(type)) {
+      m_out += "image ";
+      image(allocated);
+    } else if (auto *other = dynamic_cast<const ImageType *>(type)) {
+      m_out += "image_type ";
+      m_name(ImageKindNames, static_cast<size_t>(other->imageKind()));
+      m_out += ' ';
+      image(other);
+    } else if (auto *buffer = dynamic_cast<const BufferType *>(type)) {
+      m_out += "buffer ";
+      m_name(OwnerNames, buffer->ownerType());
+      m_out += ' ';
+      m_number(buffer->elementSize());
+      m_out += 'x';
+      m_number(buffer->extent());
+    } else {
+      m_out += "opaque";
+    }
+    m_out += '\n';
+    return found->second;
+  }
+
+  /// Declares operands from outside of the graph not used yet.
+  void m_externals(std::span<const Use> operands) {
+    for (auto &use : operands) {
+      auto *value = use.value();
+      if (dynamic_cast<NullConstant *>(value) || m_values.contains(value) ||
+          m_external.contains(value))
+        continue;
+      auto *action = dynamic_cast<const Action *>(value);
+      assert(!(action && m_graph.contains(action)) &&
+             "operand must precede its user");
+      auto type = m_type(value->type());
+      m_out += '$';
+      m_number(m_external.size());
+      m_out += " = external !";
+      m_number(type);
+      m_out += '\n';
+      m_external.emplace(value, m_external.size());
+    }
+  }
+
+  void m_operand(const Use &use) {
+    if (dynamic_cast<NullConstant *>(use.value())) {
+      m_out += "null";
+      return;
+    }
+    if (auto found = m_values.find(use.value()); found != m_values.end()) {
+      m_out += '%';
+      m_number(found->second);
+      return;
+    }
+    m_out += '$';
+    m_number(m_external.at(use.value()));
+  }
+
+  void m_operands(std::span<const Use> operands) {
+    for (auto &use : operands) {
+      if (&use != operands.data())
+        m_out += ", ";
+      m_operand(use);
+    }
+  }
+
+  void m_range(const SubresourceRange &range) {
+    m_out += '[';
+    m_number(range.baseMipLevel);
+    m_out += ':';
+    m_count(range.mipLevelCount);
+    m_out += ", ";
+    m_number(range.baseArrayLayer);
+    m_out += ':';
+    m_count(range.arrayLayerCount);
+    m_out += ']';
+  }
+
+  void m_realOperand(const Use &use, const SubresourceRange &range,
+                     AccessUsage access) {
+    m_operand(use);
+    if (!range.whole())
+      m_range(range);
+    if (access != AccessUsage::Unknown) {
+      m_out += ' ';
+      m_name(AccessNames, static_cast<size_t>(access));
+    }
+  }
+
+  void m_realOperands(const RealAction *action) {
+    m_realOperand(action->operands()[0], action->range(), action->access());
+    m_out += ", ";
+    m_realOperand(action->operands()[1], action->useRange(),
+                  action->useAccess());
+  }
+
+  void m_action(const Action *action) {
+    auto kind = action->actionKind();
+    auto typed = kind == Action::Kind::Allocation ||
+                 kind == Action::Kind::Composition;
+    auto type = typed ? m_type(action->type()) : 0u;
+    m_externals(action->operands());
+    auto typeRef = [&] {
+      m_out += '!';
+      m_number(type);
+    };
+
+    m_out += '%';
+    m_number(m_values.size());
+    m_out += " = ";
+    if (auto *sub = dynamic_cast<const SubAllocation *>(action)) {
+      m_out += "suballoc ";
+      typeRef();
+      m_out += " offset ";
+      m_number(sub->offset());
+      m_out += ' ';
+      m_operands(action->operands());
+    } else if (auto *import = dynamic_cast<const Import *>(action)) {
+      m_out += "import ";
+      typeRef();
+      m_out += ' ';
+      m_number(import->resourceID());
+      m_out += import->access() == Import::Access::History ? " history"
+                                                            : " current";
+    } else if (auto *transfer = dynamic_cast<const Transfer *>(action)) {
+      m_out += transfer->direction() == Transfer::Direction::Upload
+                   ? "transfer upload batch "
+                   : "transfer readback batch ";
+      m_number(transfer->batch());
+      m_out += " offset ";
+      m_number(transfer->stagingOffset());
+      m_out += ' ';
+      m_realOperands(transfer);
+    } else if (auto *transfer = dynamic_cast<const DeviceTransfer *>(action)) {
+      m_out += "device_transfer ";
+      m_number(transfer->from());
+      m_out += ' ';
+      m_number(transfer->to());
+      m_out += ' ';
+      m_realOperands(transfer);
+    } else {
+      switch (kind) {
+      case Action::Kind::Allocation:
+        m_out += "alloc ";
+        typeRef();
+        if (!action->operands().empty()) {
+          m_out += ' ';
+          m_operands(action->operands());
+        }
+        break;
+      case Action::Kind::Composition:
+        m_out += "compose ";
+        typeRef();
+        m_out += ' ';
+        m_operands(action->operands());
+        break;
+      case Action::Kind::RealAction: {
+        auto *real = static_cast<const RealAction *>(action);
+        m_out += "real ";
+        if (!real->readRange().empty()) {
+          m_out += "reads ";
+          m_range(real->readRange());
+          m_out += ' ';
+        }
+        m_realOperands(real);
+        break;
+      }
+      case Action::Kind::Terminator:
+        m_out += "terminate ";
+        m_operands(action->operands());
+        break;
+      }
+    }
+    m_out += '\n';
+  }
+
+  const Graph &m_graph;
+  std::ostream &m_os;
+  std::string m_out;
+  std::unordered_map<const Type *, size_t> m_types;
+  std::unordered_map<const Value *, size_t> m_values;
+  std::unordered_map<const Value *, size_t> m_external;
+};
+
+} // namespace
+
+void printGraph(const Graph &graph, std::ostream &os) {
+  Printer{graph, os}.print();
+}
+
+bool GraphParser::parse(std::istream &is) {
+  std::vector<char> buffer(BlockSize);
+  size_t filled = 0;
+  while (true) {
+    is.read(buffer.data() + filled, buffer.size() - filled);
+    filled += is.gcount();
+    auto data = std::string_view{buffer.data(), filled};
+    size_t start = 0;
+    for (auto end = data.find('\n'); end != data.npos;
+         end = data.find('\n', start)) {
+      if (!parseLine(data.substr(start, end - start)))
+        return false;
+      start = end + 1;
+    }
+    if (!is)
+      return start == filled || parseLine(data.substr(start));
+    // Incomplete line is moved to the front, buffer grows if it is full
+    std::memmove(buffer.data(), buffer.data() + start, filled - start);
+    filled -= start;
+    if (filled == buffer.size())
+      buffer.resize(buffer.size() * 2);
+  }
+}
+
+bool GraphParser::parseLine(std::string_view line) {
+  ++m_line;
+  m_rest = line;
+  m_skipSpaces();
+  if (m_rest.empty() || m_rest.front() == ';')
+    return true;
+  if (m_consume('!'))
+    return m_parseType();
+  if (m_consume('%'))
+    return m_parseAction();
+  if (m_consume('$'))
+    return m_parseExternal();
+  return m_fail("expected type, action or external definition");
+}
+
+bool GraphParser::m_fail(std::string_view message) {
+  if (m_error.empty())
+    m_error = message;
+  return false;
+}
+
+bool GraphParser::m_parseType() {
+  std::uint64_t id;
+  if (!m_number(id) || id != m_types.size())
+    return m_fail("types must be numbered in order of definition");
+  if (!m_consume('='))
+    return m_fail("expected '='");
+
+  auto image = [&](ImageType::ImageKind kind, bool allocated) -> Type * {
+    auto format = lookup(PixelFormatNames, m_word());
+    auto extentType = lookup(ExtentTypeNames, m_word());
+    std::array<std::uint64_t, 3> extents;
+    std::uint64_t mipLevels, arrayLayers;
+    if (!format || !extentType) {
+      m_fail("unknown pixel format or extent type");
+      return nullptr;
+    }
+    if (!m_number(extents[0]) || !m_consume('x') || !m_number(extents[1]) ||
+        !m_consume('x') || !m_number(extents[2]) || m_word() != "mips" ||
+        !m_number(mipLevels) || m_word() != "layers" ||
+        !m_number(arrayLayers)) {
+      m_fail("malformed image type");
+      return nullptr;
+    }
+    if (mipLevels == 0 || arrayLayers == 0 || mipLevels > ~0u ||
+        arrayLayers > ~0u) {
+      m_fail("invalid number of mip levels or array layers");
+      return nullptr;
+    }
+    auto pf = static_cast<ImageType::PixelFormat>(*format);
+    auto et = static_cast<ImageType::ExtentType>(*extentType);
+    std::array<size_t, 3> sizes = {extents[0], extents[1], extents[2]};
+    if (allocated)
+      return m_graph.getType<AllocatedImageType>(
+          pf, et, unsigned(mipLevels), sizes, unsigned(arrayLayers));
+    return m_graph.getType<ImageType>(kind, pf, et, unsigned(mipLevels),
+                                      sizes, unsigned(arrayLayers));
+  };
+
+  Type *type = nullptr;
+  auto kind = m_word();
+  if (kind == "null" || kind == "opaque") {
+    type = m_graph.getType<NullType>();
+  } else if (kind == "image") {
+    type = image(ImageType::ImageKind::Allocated, true);
+  } else if (kind == "image_type") {
+    auto imageKind = lookup(ImageKindNames, m_word());
+    if (!imageKind)
+      return m_fail("unknown image kind");
+    type = image(static_cast<ImageType::ImageKind>(*imageKind), false);
+  } else if (kind == "screen_buffer") {
+    std::uint64_t swapChain;
+    if (!m_number(swapChain) || swapChain > ~0u)
+      return m_fail("expected swap chain ID");
+    type = m_graph.getType<ScreenBufferImage>(unsigned(swapChain));
+  } else if (kind == "tied_image") {
+    auto format = lookup(PixelFormatNames, m_word());
+    std::uint64_t swapChain;
+    if (!format)
+      return m_fail("unknown pixel format");
+    if (!m_number(swapChain) || swapChain > ~0u)
+      return m_fail("expected swap chain ID");
+    type = m_graph.getType<TiedToScreenBufferImage>(
+        static_cast<ImageType::PixelFormat>(*format), unsigned(swapChain));
+  } else if (kind == "buffer") {
+    auto owner = lookup(OwnerNames, m_word());
+    std::uint64_t elementSize, elementCount;
+    if (!owner)
+      return m_fail("unknown buffer owner");
+    if (!m_number(elementSize) || !m_consume('x') ||
+        !m_number(elementCount) || elementSize == 0)
+      return m_fail("malformed buffer type");
+    type = m_graph.getType<BufferType>(
+        static_cast<ScalarType::OwnerType>(*owner), elementSize, elementCount);
+  } else {
+    return m_fail("unknown type");
+  }
+  if (!type)
+    return false;
+  m_skipSpaces();
+  if (!m_rest.empty())
+    return m_fail("unexpected characters after type");
+  m_types.push_back(type);
+  return true;
+}
+
+bool GraphParser::m_parseAction() {
+  std::uint64_t id;
+  if (!m_number(id) || id != m_actions.size())
+    return m_fail("actions must be numbered in graph order");
+  if (!m_consume('='))
+    return m_fail("expected '='");
+
+  auto plain = [&] {
+    return std::ranges::all_of(m_attributes, [](auto &attributes) {
+      return attributes.first.whole() &&
+             attributes.second == AccessUsage::Unknown;
+    });
+  };
+  auto wholeRanges = [&] {
+    return m_attributes[0].first.whole() && m_attributes[1].first.whole();
+  };
+  auto realAction = [&](RealAction *action) {
+    action->setAccess(m_attributes[0].second);
+    action->setUseAccess(m_attributes[1].second);
+    return action;
+  };
+
+  Action *action = nullptr;
+  auto kind = m_word();
+  if (kind == "alloc") {
+    auto *type = m_readType();
+    if (!type)
+      return false;
+    m_skipSpaces();
+    if (m_rest.empty())
+      action = new Allocation{type};
+    else if (m_readOperands(1) && plain() && m_checkOperands() &&
+             m_checkKind(m_operands[0], Action::Kind::Composition))
+      action = new Allocation{type, m_operands[0]};
+  } else if (kind == "suballoc") {
+    auto *type = m_readType();
+    std::uint64_t offset;
+    if (!type || m_word() != "offset" || !m_number(offset))
+      return m_fail("malformed suballocation");
+    if (m_readOperands(1) && plain() && m_checkOperands() &&
+        m_checkKind(m_operands[0], Action::Kind::Allocation))
+      action = new SubAllocation{type, m_operands[0], offset};
+  } else if (kind == "import") {
+    auto *type = m_readType();
+    std::uint64_t resourceID;
+    if (!type || !m_number(resourceID) || resourceID > ~0u)
+      return m_fail("malformed import");
+    auto access = m_word();
+    if (access != "current" && access != "history")
+      return m_fail("expected import access");
+    action = new Import{type, unsigned(resourceID),
+                        access == "history" ? Import::Access::History
+                                            : Import::Access::Current};
+  } else if (kind == "compose") {
+    auto *type = m_readType();
+    if (type && m_readOperands(0) && plain() && m_checkOperands())
+      action = new Composition{type, m_operands};
+  } else if (kind == "real") {
+    auto readRange = SubresourceRange::none();
+    m_skipSpaces();
+    if (m_rest.starts_with("reads")) {
+      m_word();
+      if (!m_readRange(readRange))
+        return false;
+    }
+    if (m_readOperands(2) && m_checkOperands() &&
+        m_checkVersion(m_operands[0]) &&
+        (readRange.empty() || m_checkRange(readRange, m_operands[0])))
+      action = realAction(new RealAction{
+          m_operands[0], m_operands[1], m_attributes[0].first,
+          m_attributes[1].first, readRange});
+  } else if (kind == "transfer") {
+    auto direction = m_word();
+    std::uint64_t batch, offset;
+    if ((direction != "upload" && direction != "readback") ||
+        m_word() != "batch" || !m_number(batch) || batch > ~0u ||
+        m_word() != "offset" || !m_number(offset))
+      return m_fail("malformed transfer");
+    if (m_readOperands(2) && wholeRanges() && m_checkOperands() &&
+        m_checkVersion(m_operands[0])) {
+      auto *transfer = new Transfer{m_operands[0], m_operands[1],
+                                    direction == "upload"
+                                        ? Transfer::Direction::Upload
+                                        : Transfer::Direction::Readback};
+      transfer->setStaging(unsigned(batch), offset);
+      action = realAction(transfer);
+    }
+  } else if (kind == "device_transfer") {
+    std::uint64_t from, to;
+    if (!m_number(from) || !m_number(to) || from > ~0u || to > ~0u)
+      return m_fail("malformed device transfer");
+    if (m_readOperands(2) && wholeRanges() && m_checkOperands() &&
+        m_checkVersion(m_operands[0]))
+      action = realAction(new DeviceTransfer{m_operands[0], m_operands[1],
+                                             unsigned(from), unsigned(to)});
+  } else if (kind == "terminate") {
+    if (m_readOperands(1) && plain() && m_checkOperands() &&
+        m_checkAction(m_operands[0]))
+      action = new Terminator{m_graph.types(), m_operands[0]};
+  } else {
+    return m_fail("unknown action");
+  }
+  if (!action)
+    return m_fail("malformed operands");
+  m_skipSpaces();
+  if (!m_rest.empty()) {
+    delete action;
+    return m_fail("unexpected characters after action");
+  }
+  m_graph.push_back(action);
+  m_actions.push_back(action);
+  return true;
+}
+
+bool GraphParser::m_parseExternal() {
+  std::uint64_t id;
+  if (!m_number(id) || id != m_externals.size())
+    return m_fail("externals must be numbered in order of declaration");
+  if (!m_consume('=') || m_word() != "external")
+    return m_fail("malformed external");
+  auto *type = m_readType();
+  if (!type)
+    return false;
+  m_skipSpaces();
+  if (!m_rest.empty())
+    return m_fail("unexpected characters after external");
+  if (id >= m_bound.size())
+    return m_fail("external is not bound");
+  if (!type->equal(m_bound[id]->type()))
+    return m_fail("bound external is of other type");
+  m_externals.push_back(m_bound[id]);
+  return true;
+}
+
+Type *GraphParser::m_readType() {
+  std::uint64_t id;
+  if (!m_consume('!') || !m_number(id) || id >= m_types.size()) {
+    m_fail("expected defined type");
+    return nullptr;
+  }
+  return m_types[id];
+}
+
+Value *GraphParser::m_readOperand() {
+  std::uint64_t id;
+  if (m_consume('%')) {
+    if (!m_number(id) || id >= m_actions.size()) {
+      m_fail("expected defined action");
+      return nullptr;
+    }
+    return m_actions[id];
+  }
+  if (m_consume('$')) {
+    if (!m_number(id) || id >= m_externals.size()) {
+      m_fail("expected declared external");
+      return nullptr;
+    }
+    return m_externals[id];
+  }
+  if (m_word() != "null") {
+    m_fail("expected operand");
+    return nullptr;
+  }
+  return m_graph.getConstant<NullConstant>(m_graph.types());
+}
+
+bool GraphParser::m_readOperands(size_t count) {
+  m_operands.clear();
+  m_attributes.clear();
+  do {
+    auto *operand = m_readOperand();
+    if (!operand)
+      return false;
+    auto range = SubresourceRange{};
+    m_skipSpaces();
+    if (!m_rest.empty() && m_rest.front() == '[' && !m_readRange(range))
+      return false;
+    m_operands.push_back(operand);
+    m_attributes.emplace_back(range, m_readAccess());
+    if (!m_error.empty())
+      return false;
+  } while (m_consume(','));
+  if (count != 0 && m_operands.size() != count)
+    return m_fail("wrong number of operands");
+  return true;
+}
+
+bool GraphParser::m_checkOperands() {
+  for (size_t i = 0; i < m_operands.size(); ++i) {
+    auto *action = dynamic_cast<Action *>(m_operands[i]);
+    if (action && action->actionKind() == Action::Kind::Terminator)
+      return m_fail("terminated value can't be used");
+    if (!m_checkRange(m_attributes[i].first, m_operands[i]))
+      return false;
+  }
+  return true;
+}
+
+bool GraphParser::m_checkRange(const SubresourceRange &range, Value *value) {
+  unsigned mipLevels = 1u, arrayLayers = 1u;
+  if (auto *image = dynamic_cast<const ImageType *>(value->type())) {
+    mipLevels = image->mipLevels();
+    arrayLayers = image->arrayLayers();
+  }
+  if (!range.within(mipLevels, arrayLayers))
+    return m_fail("subresource range out of resource");
+  return true;
+}
+
+bool GraphParser::m_checkAction(Value *value) {
+  if (!dynamic_cast<Action *>(value))
+    return m_fail("expected action operand");
+  return true;
+}
+
+bool GraphParser::m_checkKind(Value *value, Action::Kind kind) {
+  auto *action = dynamic_cast<Action *>(value);
+  if (!action || action->actionKind() != kind)
+    return m_fail(kind == Action::Kind::Composition
+                      ? "expected composition operand"
+                      : "expected allocation operand");
+  return true;
+}
+
+bool GraphParser::m_checkVersion(Value *value) {
+  // Resource is defined by an Allocation and then by every RealAction
+  auto *action = dynamic_cast<Action *>(value);
+  if (!action || (action->actionKind() != Action::Kind::Allocation &&
+                  action->actionKind() != Action::Kind::RealAction))
+    return m_fail("expected resource version as useDef operand");
+  return true;
+}
+
+bool GraphParser::m_readRange(SubresourceRange &range) {
+  // [baseMipLevel:mipLevelCount, baseArrayLayer:arrayLayerCount]
+  constexpr char Separators[] = {'[', ':', ',', ':'};
+  std::array<std::uint16_t, 4> fields;
+  for (size_t i = 0; i < fields.size(); ++i) {
+    if (!m_consume(Separators[i]))
+      return m_fail("malformed subresource range");
+    std::uint64_t value;
+    if (i % 2 && (m_skipSpaces(), m_rest.starts_with("all"))) {
+      m_rest.remove_prefix(3);
+      value = SubresourceRange::All;
+    } else if (!m_number(value) || value > SubresourceRange::All) {
+      return m_fail("malformed subresource range");
+    }
+    fields[i] = value;
+  }
+  if (!m_consume(']'))
+    return m_fail("malformed subresource range");
+  range = {fields[0], fields[1], fields[2], fields[3]};
+  return true;
+}
+
+AccessUsage GraphParser::m_readAccess() {
+  m_skipSpaces();
+  if (m_rest.empty() || m_rest.front() == ',')
+    return AccessUsage::Unknown;
+  auto access = lookup(AccessNames, m_word());
+  if (!access) {
+    m_fail("unknown access");
+    return AccessUsage::Unknown;
+  }
+  return static_cast<AccessUsage>(*access);
+}
+
+std::string_view GraphParser::m_word() {
+  m_skipSpaces();
+  auto length = std::ranges::find_if_not(m_rest, [](char c) {
+                  return std::isalnum(static_cast<unsigned char>(c)) ||
+                         c == '_';
+                }) -
+                m_rest.begin();
+  auto word = m_rest.substr(0, length);
+  m_rest.remove_prefix(length);
+  return word;
+}
+
+bool GraphParser::m_number(std::uint64_t &value) {
+  m_skipSpaces();
+  auto [end, error] =
+      std::from_chars(m_rest.data(), m_rest.data() + m_rest.size(), value);
+  if (error != std::errc{})
+    return false;
+  m_rest.remove_prefix(end - m_rest.data());
+  return true;
+}
+
+bool GraphParser::m_consume(char c) {
+  m_skipSpaces();
+  if (m_rest.empty() || m_rest.front() != c)
+    return false;
+  m_rest.remove_prefix(1);
+  return true;
+}
+
+void GraphParser::m_skipSpaces() {
+  while (!m_rest.empty() &&
+         (m_rest.front() == ' ' || m_rest.front() == '\t' ||
+          m_rest.front() == '\r'))
+    m_rest.remove_prefix(1);
+}
+
+} // namespace rgc
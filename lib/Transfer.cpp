@@ -0,0 +1,216 @@
+#include <algorithm>
+#include <numeric>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "rgc/Suballocation.hpp"
+#include "rgc/Transfer.hpp"
+#include "rgc/Types.hpp"
+
+namespace rgc {
+
+namespace {
+
+ScalarType::OwnerType ownerOf(const Type *type) {
+  if (auto *scalar = dynamic_cast<const ScalarType *>(type))
+    return scalar->ownerType();
+  return ScalarType::OwnerType::None;
+}
+
+size_t alignUp(size_t value, size_t alignment) {
+  return (value + alignment - 1u) / alignment * alignment;
+}
+
+/// Action reading content of its operand at @p index: 'use' of a RealAction
+/// or operand of a dynamic Allocation. SubAllocation only views its block.
+bool reads(const Action *user, unsigned index) {
+  switch (user->actionKind()) {
+  case Action::Kind::RealAction:
+    return index == 1u && !dynamic_cast<const Transfer *>(user);
+  case Action::Kind::Allocation:
+    return !dynamic_cast<const SubAllocation *>(user);
+  default:
+    return false;
+  }
+}
+
+/// Calls @p visit for every action reading @p value, either directly or
+/// through any number of Compositions.
+template <typename F> void forEachReader(const Value *value, F &&visit) {
+  for (auto &use : value->users()) {
+    auto *user = use.user();
+    if (user->actionKind() == Action::Kind::Composition)
+      forEachReader(user, visit);
+    else if (reads(user, use.index()))
+      visit(user);
+  }
+}
+
+struct Site {
+  Action *user;
+  unsigned index;
+};
+
+struct Pending {
+  Value *source;
+  const BufferType *type;
+  Transfer::Direction direction;
+  // Uses of source to redirect to the transfer
+  std::vector<Site> sites;
+  // Transfer may be placed before any action at position >= ready
+  size_t ready;
+  // Position of the first site and of the last reader
+  size_t deadline;
+  size_t last;
+};
+
+struct InFlight {
+  unsigned batch;
+  size_t begin;
+  size_t end;
+};
+
+} // namespace
+
+TransferPlan planTransfers(Graph &graph, const TransferOptions &options) {
+  std::unordered_map<const Value *, size_t> positions;
+  std::vector<Action *> actions;
+  for (auto *action : graph) {
+    positions.emplace(action, actions.size());
+    actions.push_back(action);
+  }
+
+  // Sources are actions and external values, in order of their first use.
+  // Compositions hold no content, reads through them reach their operands
+  std::vector<Value *> sources;
+  std::unordered_set<const Value *> seen;
+  for (auto *action : actions) {
+    for (auto *value : action->uses())
+      if (!positions.contains(value) && seen.insert(value).second)
+        sources.push_back(value);
+    if (action->actionKind() != Action::Kind::Composition)
+      sources.push_back(action);
+  }
+
+  TransferPlan plan;
+  std::vector<Pending> pending;
+  for (auto *source : sources) {
+    auto *buffer = dynamic_cast<const BufferType *>(source->type());
+    if (!buffer)
+      continue;
+    auto from = buffer->ownerType();
+    Transfer::Direction direction;
+    ScalarType::OwnerType to;
+    if (from == ScalarType::OwnerType::Host) {
+      direction = Transfer::Direction::Upload;
+      to = ScalarType::OwnerType::Device;
+    } else if (from == ScalarType::OwnerType::Device) {
+      direction = Transfer::Direction::Readback;
+      to = ScalarType::OwnerType::Host;
+    } else {
+      continue;
+    }
+
+    auto defined = positions.find(source);
+    auto ready = defined == positions.end() ? 0u : defined->second + 1u;
+    auto transfer = Pending{source, buffer, direction, {}, ready, 0, 0};
+    for (auto &use : source->users()) {
+      auto *user = use.user();
+      auto needed = false;
+      auto check = [&](const Action *reader) {
+        if (ownerOf(reader->type()) != to)
+          return;
+        needed = true;
+        transfer.last = std::max(transfer.last, positions.at(reader));
+      };
+      if (user->actionKind() == Action::Kind::Composition)
+        forEachReader(user, check);
+      else if (reads(user, use.index()))
+        check(user);
+      if (!needed)
+        continue;
+      auto position = positions.at(user);
+      if (transfer.sites.empty() || position < transfer.deadline)
+        transfer.deadline = position;
+      transfer.sites.push_back({user, use.index()});
+    }
+    if (transfer.sites.empty())
+      continue;
+    if (alignUp(buffer->byteSize(), options.alignment) > options.stagingSize)
+      plan.oversized.push_back(source);
+    else
+      pending.push_back(std::move(transfer));
+  }
+
+  std::vector<size_t> order(pending.size());
+  std::iota(order.begin(), order.end(), 0u);
+  std::ranges::stable_sort(order, {},
+                           [&](size_t i) { return pending[i].deadline; });
+
+  std::vector<bool> planned(pending.size(), false);
+  std::vector<InFlight> inFlight;
+  size_t ring = 0;
+  for (auto first = order.begin(); first != order.end(); ++first) {
+    if (planned[*first])
+      continue;
+    auto &head = pending[*first];
+    auto *anchor = actions[head.deadline];
+    auto batch = TransferBatch{};
+    batch.direction = head.direction;
+    std::vector<size_t> members;
+    for (auto next = first; next != order.end(); ++next) {
+      auto &candidate = pending[*next];
+      if (planned[*next] || candidate.direction != head.direction ||
+          candidate.ready > head.deadline)
+        continue;
+      auto bytes = alignUp(candidate.type->byteSize(), options.alignment);
+      if (batch.bytes + bytes > options.stagingSize)
+        continue;
+      planned[*next] = true;
+      members.push_back(*next);
+      batch.bytes += bytes;
+    }
+
+    // Staging memory is reused only once batches occupying it are complete
+    if (ring + batch.bytes > options.stagingSize)
+      ring = 0;
+    auto index = static_cast<unsigned>(plan.batches.size());
+    std::erase_if(inFlight, [&](const InFlight &other) {
+      if (other.end <= ring || ring + batch.bytes <= other.begin)
+        return false;
+      batch.waits.push_back(other.batch);
+      return true;
+    });
+    std::ranges::sort(batch.waits);
+    inFlight.push_back({index, ring, ring + batch.bytes});
+
+    auto owner = head.direction == Transfer::Direction::Upload
+                     ? ScalarType::OwnerType::Device
+                     : ScalarType::OwnerType::Host;
+    std::vector<Allocation *> destinations;
+    for (auto i : members) {
+      auto &member = pending[i];
+      auto *destination = new Allocation{graph.getType<BufferType>(
+          owner, member.type->elementSize(), member.type->extent())};
+      graph.insertBefore(destination, anchor);
+      destinations.push_back(destination);
+    }
+    for (size_t m = 0; m < members.size(); ++m) {
+      auto &member = pending[members[m]];
+      auto *transfer =
+          new Transfer{destinations[m], member.source, member.direction};
+      transfer->setStaging(index, ring);
+      ring += alignUp(member.type->byteSize(), options.alignment);
+      graph.insertBefore(transfer, anchor);
+      for (auto site : member.sites)
+        site.user->replaceUse(site.index, transfer);
+      graph.insertAfter(new Terminator{graph.types(), transfer},
+                        actions[member.last]);
+      batch.transfers.push_back(transfer);
+    }
+    plan.batches.push_back(std::move(batch));
+  }
+  return plan;
+}
+
+} // namespace rgc
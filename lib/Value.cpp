@@ -8,20 +8,19 @@ void Value::dump(std::ostream &os) const {
   os << "Value " << this << " t: ";
   type()->dump(os);
   os << " [users: ";
-  for (auto &&[action, index] : m_users)
-    os << "(a: " << action << ", i: " << index << "); ";
-  if (m_users.empty()) {
+  for (auto &use : users())
+    os << "(a: " << use.user() << ", i: " << use.index() << "); ";
+  if (unused()) {
     os << "<unused>";
   }
   os << "]";
 }
 Value::~Value() { assert(unused() && "Trying to remove value in use"); }
 void Value::replaceAllUsesWith(Value *value) {
-  for (auto &&[action, index] : m_users) {
-    action->replaceUse(index, value);
-    value->addUser(action, index);
-  }
-  m_users.clear();
+  assert(value != this && "value can't replace itself");
+  // Every replacement unlinks the first use
+  while (auto *use = m_firstUse)
+    use->user()->replaceUse(use->index(), value);
 }
 
 } // namespace rgc
\ No newline at end of file
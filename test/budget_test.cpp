@@ -0,0 +1,187 @@
+#include <algorithm>
+
+#include "rgc/Action.hpp"
+#include "rgc/Budget.hpp"
+#include "rgc/Graph.hpp"
+#include "rgc/Resolution.hpp"
+#include "rgc/ResourceIndex.hpp"
+#include "rgc/Transfer.hpp"
+#include "rgc/Types.hpp"
+
+namespace {
+
+struct Frame {
+  rgc::Graph graph;
+  rgc::Allocation *a;
+  rgc::RealAction *clearA, *mix;
+  size_t imageSize;
+
+  // A and B are read again at the end of the frame, while C and D are
+  // worked on in between. Screen sized images are 256x256 once resolved
+  explicit Frame(bool screenSized = false) {
+    auto *nc = graph.getConstant<rgc::NullConstant>(graph.types());
+    size_t extents[] = {256u, 256u, 1u};
+    rgc::Type *type = graph.getType<rgc::AllocatedImageType>(
+        rgc::ImageType::PixelFormat::R8G8B8A8_UNORM,
+        rgc::ImageType::ExtentType::T2D, 1u, extents);
+    imageSize = rgc::byteSize(type);
+    if (screenSized)
+      type = graph.getType<rgc::TiedToScreenBufferImage>(
+          rgc::ImageType::PixelFormat::R8G8B8A8_UNORM, 0u);
+    a = new rgc::Allocation{type};
+    auto *b = new rgc::Allocation{type};
+    auto *c = new rgc::Allocation{type};
+    auto *d = new rgc::Allocation{type};
+    clearA = new rgc::RealAction{a, nc};
+    auto *copyA = new rgc::RealAction{b, clearA};
+    auto *clearC = new rgc::RealAction{c, nc};
+    auto *blur = new rgc::RealAction{d, clearC};
+    auto *composite = new rgc::RealAction{blur, copyA};
+    mix = new rgc::RealAction{composite, clearA};
+    for (auto *action : std::vector<rgc::Action *>{
+             a, clearA, b, copyA, c, clearC, d, blur,
+             new rgc::Terminator{graph.types(), clearC}, composite, mix,
+             new rgc::Terminator{graph.types(), clearA},
+             new rgc::Terminator{graph.types(), copyA},
+             new rgc::Terminator{graph.types(), mix}})
+      graph.push_back(action);
+  }
+};
+
+/// A is filled from small parameters buffer P that lives through the whole
+/// frame and, if asked, is written again while C and D are worked on.
+struct ParamsFrame {
+  rgc::Graph graph;
+  rgc::Allocation *a;
+  rgc::RealAction *fillP, *fillA, *composite;
+  size_t imageSize;
+
+  explicit ParamsFrame(bool rewriteParams) {
+    auto *nc = graph.getConstant<rgc::NullConstant>(graph.types());
+    size_t extents[] = {256u, 256u, 1u};
+    auto *type = graph.getType<rgc::AllocatedImageType>(
+        rgc::ImageType::PixelFormat::R8G8B8A8_UNORM,
+        rgc::ImageType::ExtentType::T2D, 1u, extents);
+    imageSize = rgc::byteSize(type);
+    auto *p = new rgc::Allocation{graph.getType<rgc::BufferType>(
+        rgc::ScalarType::OwnerType::Device, 4u, 4u)};
+    a = new rgc::Allocation{type};
+    auto *c = new rgc::Allocation{type};
+    auto *d = new rgc::Allocation{type};
+    fillP = new rgc::RealAction{p, nc};
+    fillA = new rgc::RealAction{a, fillP};
+    auto *clearC = new rgc::RealAction{c, nc};
+    auto *blur = new rgc::RealAction{d, clearC};
+    composite = new rgc::RealAction{blur, fillA};
+    std::vector<rgc::Action *> actions{p, fillP, a, fillA, c, clearC, d, blur};
+    rgc::Action *lastP = fillP;
+    if (rewriteParams) {
+      lastP = new rgc::RealAction{fillP, nc};
+      actions.push_back(lastP);
+    }
+    actions.insert(actions.end(),
+                   {new rgc::Terminator{graph.types(), clearC}, composite,
+                    new rgc::Terminator{graph.types(), fillA},
+                    new rgc::Terminator{graph.types(), composite},
+                    new rgc::Terminator{graph.types(), lastP}});
+    for (auto *action : actions)
+      graph.push_back(action);
+  }
+};
+
+} // namespace
+
+int main() {
+  {
+    // Clear of A is cheaper to repeat than a round trip through Host
+    auto frame = Frame{};
+    auto report = rgc::fitMemoryBudget(
+        frame.graph, 3 * frame.imageSize,
+        {.cost = {}, .byteCost = 1e-5, .reorder = false});
+    assert(report.peakBefore == 4 * frame.imageSize);
+    assert(report.fits);
+    assert(report.peakAfter == 3 * frame.imageSize);
+    assert(report.rematerialized == 1 && report.spilled == 0);
+    auto *clone = dynamic_cast<rgc::RealAction *>(frame.mix->getUse());
+    assert(clone && clone != frame.clearA);
+    assert(clone->getUse() == frame.clearA->getUse());
+
+    auto index = rgc::ResourceIndex{frame.graph};
+    assert(index.terminator(frame.a));
+    assert(index.resourceOf(clone) != frame.a);
+  }
+  {
+    // Expensive work is spilled instead
+    auto frame = Frame{};
+    auto report = rgc::fitMemoryBudget(
+        frame.graph, 3 * frame.imageSize,
+        {.cost = [](auto *) { return 100.0; },
+         .byteCost = 1e-5,
+         .reorder = false});
+    assert(report.fits);
+    assert(report.peakAfter == 3 * frame.imageSize);
+    assert(report.rematerialized == 0 && report.spilled == 1);
+    auto *upload = dynamic_cast<rgc::Transfer *>(frame.mix->getUse());
+    assert(upload &&
+           upload->direction() == rgc::Transfer::Direction::Upload);
+    auto *readback = dynamic_cast<rgc::Transfer *>(upload->getUse());
+    assert(readback && readback->getUse() == frame.clearA);
+  }
+  {
+    // C and D are both accessed at the peak, which can't go lower
+    auto frame = Frame{};
+    auto report = rgc::fitMemoryBudget(frame.graph, 2 * frame.imageSize,
+                                       {.cost = {}, .spill = false});
+    assert(!report.fits);
+    assert(report.bottleneck);
+    assert(!report.pinned.empty());
+    assert(report.peakAfter > 2 * frame.imageSize);
+  }
+  {
+    // Screen sized images are spilled by their resolved size and weigh
+    // nothing without it
+    auto frame = Frame{true};
+    auto resolutions = rgc::ResolutionSet{};
+    resolutions.set(0u, 256u, 256u);
+    auto resolved = rgc::ResolvedGraph{frame.graph, resolutions};
+    auto options = rgc::BudgetOptions{.cost = [](auto *) { return 100.0; },
+                                      .byteCost = 1e-5,
+                                      .reorder = false,
+                                      .resolved = &resolved};
+    auto report =
+        rgc::fitMemoryBudget(frame.graph, 3 * frame.imageSize, options);
+    assert(report.peakBefore == 4 * frame.imageSize);
+    assert(report.fits && report.spilled == 1);
+    auto *upload = dynamic_cast<rgc::Transfer *>(frame.mix->getUse());
+    assert(upload);
+    auto *readback = dynamic_cast<rgc::Transfer *>(upload->getUse());
+    assert(readback && rgc::byteSize(readback->type()) == frame.imageSize);
+
+    auto unresolved = Frame{true};
+    report = rgc::fitMemoryBudget(unresolved.graph, 0u, {.cost = {}});
+    assert(report.peakBefore == 0 && report.fits);
+    assert(report.spilled == 0);
+  }
+  {
+    // Fill of A is repeated from P, which is still alive and unchanged
+    auto frame = ParamsFrame{false};
+    auto budget = 2 * frame.imageSize + 16u;
+    auto report = rgc::fitMemoryBudget(
+        frame.graph, budget, {.cost = {}, .reorder = false, .spill = false});
+    assert(report.fits && report.rematerialized == 1);
+    auto *clone = dynamic_cast<rgc::RealAction *>(frame.composite->getUse());
+    assert(clone && clone != frame.fillA);
+    assert(clone->getUse() == frame.fillP);
+  }
+  {
+    // P is written again before A is read, so A can't be refilled from it
+    auto frame = ParamsFrame{true};
+    auto budget = 2 * frame.imageSize + 16u;
+    auto report = rgc::fitMemoryBudget(
+        frame.graph, budget, {.cost = {}, .reorder = false, .spill = false});
+    assert(!report.fits);
+    assert(frame.composite->getUse() == frame.fillA);
+    assert(std::ranges::count(report.pinned, frame.a) == 1);
+  }
+  return 0;
+}
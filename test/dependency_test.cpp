@@ -0,0 +1,93 @@
+#include "rgc/Action.hpp"
+#include "rgc/Dependencies.hpp"
+#include "rgc/Graph.hpp"
+#include "rgc/Types.hpp"
+#include <algorithm>
+
+namespace {
+
+bool dependsOn(const rgc::DependencyGraph &deps, rgc::Action *action,
+               rgc::Action *on) {
+  return std::ranges::find(deps.dependencies(action), on) !=
+         deps.dependencies(action).end();
+}
+
+} // namespace
+
+int main() {
+  auto graph = rgc::Graph{};
+  auto index = rgc::ResourceIndex{graph};
+  auto *nc = graph.getConstant<rgc::NullConstant>(graph.types());
+  size_t extents[] = {256u, 256u, 1u};
+  auto *cascades = graph.getType<rgc::AllocatedImageType>(
+      rgc::ImageType::PixelFormat::R32_SFLOAT, rgc::ImageType::ExtentType::T2D,
+      1u, extents, 4u);
+  auto *mipped = graph.getType<rgc::AllocatedImageType>(
+      rgc::ImageType::PixelFormat::R8G8B8A8_UNORM,
+      rgc::ImageType::ExtentType::T2D, 3u, extents);
+
+  // Every cascade is rendered into its own layer
+  auto *shadow = new rgc::Allocation{cascades};
+  graph.push_back(shadow);
+  std::vector<rgc::RealAction *> passes;
+  rgc::Value *version = shadow;
+  for (unsigned layer = 0; layer < 4; ++layer) {
+    passes.push_back(new rgc::RealAction{
+        version, nc, rgc::SubresourceRange::layers(layer)});
+    graph.push_back(passes.back());
+    version = passes.back();
+  }
+
+  // Mip chain generation reads previous mip and writes next one
+  auto *color = new rgc::Allocation{mipped};
+  graph.push_back(color);
+  auto *mip0 =
+      new rgc::RealAction{color, version, rgc::SubresourceRange::mips(0)};
+  auto *mip1 = new rgc::RealAction{mip0, nc, rgc::SubresourceRange::mips(1),
+                                   {}, rgc::SubresourceRange::mips(0)};
+  auto *mip2 = new rgc::RealAction{mip1, nc, rgc::SubresourceRange::mips(2),
+                                   {}, rgc::SubresourceRange::mips(1)};
+  graph.push_back(mip0);
+  graph.push_back(mip1);
+  graph.push_back(mip2);
+  // Another reader of mip 0, which the chain doesn't modify anymore
+  auto *scratch = new rgc::Allocation{mipped};
+  graph.push_back(scratch);
+  auto *blur = new rgc::RealAction{scratch, mip1, {},
+                                   rgc::SubresourceRange::mips(0)};
+  graph.push_back(blur);
+  auto *shadowEnd = new rgc::Terminator{graph.types(), version};
+  auto *colorEnd = new rgc::Terminator{graph.types(), mip2};
+  auto *scratchEnd = new rgc::Terminator{graph.types(), blur};
+  graph.push_back(shadowEnd);
+  graph.push_back(colorEnd);
+  graph.push_back(scratchEnd);
+
+  auto deps = rgc::DependencyGraph{graph, index};
+  for (auto *pass : passes)
+    assert(std::ranges::equal(deps.dependencies(pass),
+                              std::array<rgc::Action *, 1>{shadow}));
+  // Reads all cascades
+  for (auto *pass : passes)
+    assert(dependsOn(deps, mip0, pass));
+  assert(dependsOn(deps, mip1, mip0));
+  assert(dependsOn(deps, mip2, mip1));
+  assert(!dependsOn(deps, mip2, mip0));
+  assert(dependsOn(deps, shadowEnd, mip0));
+  // Readers of mip 0 don't serialize with each other
+  assert(dependsOn(deps, blur, mip0));
+  assert(!dependsOn(deps, blur, mip1));
+  assert(!dependsOn(deps, mip2, blur));
+  assert(dependsOn(deps, colorEnd, blur));
+
+  auto waves = deps.waves();
+  assert(std::ranges::all_of(passes, [&](auto *pass) {
+    return std::ranges::find(waves[1], pass) != waves[1].end();
+  }));
+  auto waveOf = [&](rgc::Action *action) {
+    return std::ranges::find_if(waves, [&](auto &wave) {
+      return std::ranges::find(wave, action) != wave.end();
+    });
+  };
+  assert(waveOf(blur) == waveOf(mip1));
+}
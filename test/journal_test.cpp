@@ -0,0 +1,153 @@
+#include <sstream>
+#include <string>
+
+#include "rgc/Action.hpp"
+#include "rgc/Graph.hpp"
+#include "rgc/Journal.hpp"
+#include "rgc/Transfer.hpp"
+#include "rgc/Types.hpp"
+
+int main() {
+  auto graph = rgc::Graph{};
+  auto *nc = graph.getConstant<rgc::NullConstant>(graph.types());
+  size_t extents[] = {512u, 512u, 1u};
+  auto *imageType = graph.getType<rgc::AllocatedImageType>(
+      rgc::ImageType::PixelFormat::R8G8B8A8_UNORM,
+      rgc::ImageType::ExtentType::T2D, 4u, extents);
+  auto *hostBuffer = graph.getType<rgc::BufferType>(
+      rgc::ScalarType::OwnerType::Host, 16u, 256u);
+  auto *deviceBuffer = graph.getType<rgc::BufferType>(
+      rgc::ScalarType::OwnerType::Device, 16u, 256u);
+
+  // Part of the graph exists before journal is started
+  auto *image = new rgc::Allocation{imageType};
+  graph.push_back(image);
+
+  auto stream = std::stringstream{};
+  {
+    auto journal = rgc::GraphJournal{graph, stream};
+    auto *clear = new rgc::RealAction{image, nc};
+    clear->setAccess(rgc::AccessUsage::TransferDst);
+    graph.push_back(clear);
+    auto *mip = new rgc::RealAction{clear, nc, rgc::SubresourceRange::mips(1),
+                                    {}, rgc::SubresourceRange::mips(0)};
+    graph.insertAfter(mip, clear);
+
+    auto *staging = new rgc::Allocation{hostBuffer};
+    auto *buffer = new rgc::Allocation{deviceBuffer};
+    graph.insertBefore(staging, image);
+    graph.insertAfter(buffer, staging);
+    auto *upload = new rgc::Transfer{buffer, staging,
+                                     rgc::Transfer::Direction::Upload};
+    upload->setStaging(3u, 256u);
+    graph.push_back(upload);
+
+    // Action used before it is inserted
+    auto *late = new rgc::RealAction{mip, upload};
+    auto *end = new rgc::Terminator{graph.types(), late};
+    graph.push_back(end);
+    graph.insertBefore(late, end);
+
+    auto *extra = new rgc::RealAction{late, nc};
+    graph.insertBefore(extra, end);
+    end->replaceUse(0u, extra);
+    rgc::Value *members[] = {extra, nc};
+    auto *composition = new rgc::Composition{imageType, members};
+    graph.insertBefore(composition, end);
+    graph.erase(composition);
+
+    auto *redo = new rgc::RealAction{late, nc};
+    graph.insertAfter(redo, late);
+    extra->replaceUse(0u, redo);
+    graph.moveBefore(staging, nullptr);
+    graph.moveBefore(staging, buffer);
+
+    // Range inserted at once, before an action that is already recorded
+    auto *scratch = new rgc::Allocation{deviceBuffer};
+    auto *fill = new rgc::RealAction{scratch, nc};
+    auto *done = new rgc::Terminator{graph.types(), fill};
+    rgc::Action *range[] = {scratch, fill, done};
+    graph.insertBefore(std::span<rgc::Action *const>{range}, upload);
+    graph.push_back(new rgc::Terminator{graph.types(), upload});
+    assert(journal.size() != 0);
+  }
+
+  auto journal = stream.str();
+  auto replay = rgc::JournalReplay{stream};
+  assert(replay.run() && replay.error().empty());
+  assert(replay.records() != 0);
+  auto &copy = replay.graph();
+  assert(copy.size() == graph.size());
+  assert(copy.structuralHash() == graph.structuralHash());
+
+  auto sameProperties = [](rgc::Action *a, rgc::Action *b) {
+    auto *ra = dynamic_cast<rgc::RealAction *>(a);
+    auto *rb = dynamic_cast<rgc::RealAction *>(b);
+    if (!ra || !rb)
+      return !ra && !rb;
+    return ra->range() == rb->range() && ra->useRange() == rb->useRange() &&
+           ra->readRange() == rb->readRange() && ra->access() == rb->access();
+  };
+  assert(std::equal(graph.begin(), graph.end(), copy.begin(), sameProperties));
+  auto *upload = dynamic_cast<rgc::Transfer *>(*std::next(copy.begin(), 8));
+  assert(upload && upload->batch() == 3u && upload->stagingOffset() == 256u);
+
+  // Value from outside is recorded anew once the one it replaced is gone,
+  // even if the new one reuses its address
+  {
+    auto reuse = rgc::Graph{};
+    auto *type = reuse.getType<rgc::BufferType>(
+        rgc::ScalarType::OwnerType::Device, 16u, 256u);
+    auto *otherType = reuse.getType<rgc::BufferType>(
+        rgc::ScalarType::OwnerType::Host, 4u, 64u);
+    auto os = std::stringstream{};
+    auto *target = new rgc::Allocation{type};
+    reuse.push_back(target);
+    auto *inside = new rgc::Allocation{type};
+    reuse.push_back(inside);
+    auto *read = new rgc::RealAction{target, inside};
+    reuse.push_back(read);
+    rgc::Allocation *another;
+    {
+      auto recorder = rgc::GraphJournal{reuse, os};
+      auto *outside = new rgc::Allocation{type};
+      read->replaceUse(1u, outside);
+      read->replaceUse(1u, inside);
+      delete outside;
+      another = new rgc::Allocation{otherType};
+      read->replaceUse(1u, another);
+    }
+    auto copy = rgc::JournalReplay{os};
+    assert(copy.run());
+    auto *replayed = static_cast<rgc::RealAction *>(copy.graph().back());
+    assert(replayed->getUse()->type() != replayed->getUseDef()->type());
+    read->replaceUse(1u, inside);
+    delete another;
+  }
+
+  // Malformed journals are reported instead of being replayed
+  {
+    auto is = std::istringstream{"RGCX"};
+    auto bad = rgc::JournalReplay{is};
+    assert(!bad.step() && bad.error() == "not a graph journal");
+  }
+  for (size_t size = 0; size < journal.size(); ++size) {
+    auto is = std::istringstream{journal.substr(0, size)};
+    auto truncated = rgc::JournalReplay{is};
+    if (!truncated.run())
+      assert(!truncated.error().empty());
+  }
+  auto corrupted = 0u;
+  for (size_t i = 0; i < journal.size(); ++i) {
+    for (auto byte : {'\x00', '\x7F', '\x80', '\xFF'}) {
+      auto bytes = journal;
+      bytes[i] = byte;
+      auto is = std::istringstream{bytes};
+      auto broken = rgc::JournalReplay{is};
+      if (!broken.run())
+        ++corrupted;
+    }
+  }
+  assert(corrupted != 0);
+  return 0;
+}
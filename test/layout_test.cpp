@@ -0,0 +1,159 @@
+#include "rgc/Action.hpp"
+#include "rgc/Graph.hpp"
+#include "rgc/Layouts.hpp"
+#include "rgc/Types.hpp"
+#include <algorithm>
+
+namespace {
+
+using rgc::AccessUsage;
+using rgc::ImageLayout;
+
+rgc::RealAction *access(rgc::Graph &graph, rgc::Value *useDef,
+                        AccessUsage usage, rgc::Value *use,
+                        AccessUsage useUsage,
+                        rgc::SubresourceRange range = {},
+                        rgc::SubresourceRange useRange = {}) {
+  auto *action = new rgc::RealAction{useDef, use, range, useRange};
+  action->setAccess(usage);
+  action->setUseAccess(useUsage);
+  graph.push_back(action);
+  return action;
+}
+
+size_t countTransitions(const rgc::LayoutPlan &plan,
+                        rgc::Allocation *resource) {
+  return std::ranges::count(plan.transitions(), resource,
+                            &rgc::LayoutTransition::resource);
+}
+
+} // namespace
+
+int main() {
+  auto graph = rgc::Graph{};
+  auto *nc = graph.getConstant<rgc::NullConstant>(graph.types());
+  size_t extents[] = {256u, 256u, 1u};
+  auto *color = graph.getType<rgc::AllocatedImageType>(
+      rgc::ImageType::PixelFormat::R8G8B8A8_UNORM,
+      rgc::ImageType::ExtentType::T2D, 1u, extents);
+  auto *mipped = graph.getType<rgc::AllocatedImageType>(
+      rgc::ImageType::PixelFormat::R8G8B8A8_UNORM,
+      rgc::ImageType::ExtentType::T2D, 3u, extents);
+
+  // G-buffer is rendered once and sampled by two passes
+  auto *gbuffer = new rgc::Allocation{color};
+  auto *ao = new rgc::Allocation{color};
+  auto *hdr = new rgc::Allocation{color};
+  auto *screen = new rgc::Allocation{graph.getType<rgc::ScreenBufferImage>(0u)};
+  for (auto *allocation : {gbuffer, ao, hdr, screen})
+    graph.push_back(allocation);
+  auto *geometry = access(graph, gbuffer, AccessUsage::ColorAttachment, nc,
+                          AccessUsage::Unknown);
+  auto *ssao = access(graph, ao, AccessUsage::Storage, geometry,
+                      AccessUsage::Sampled);
+  auto *lighting = access(graph, hdr, AccessUsage::ColorAttachment, geometry,
+                          AccessUsage::Sampled);
+  auto *composite = access(graph, lighting, AccessUsage::ColorAttachment,
+                           ssao, AccessUsage::Sampled);
+  auto *tonemap = access(graph, screen, AccessUsage::ColorAttachment,
+                         composite, AccessUsage::Sampled);
+  auto *present = new rgc::Terminator{graph.types(), tonemap};
+  graph.push_back(present);
+
+  // Mip chain is generated by sampling the previous level
+  auto *pyramid = new rgc::Allocation{mipped};
+  graph.push_back(pyramid);
+  rgc::Value *version =
+      access(graph, pyramid, AccessUsage::TransferDst, nc, AccessUsage::Unknown,
+             rgc::SubresourceRange::mips(0));
+  std::vector<rgc::RealAction *> downsamples;
+  for (std::uint16_t mip = 1; mip < 3; ++mip) {
+    downsamples.push_back(access(graph, version, AccessUsage::ColorAttachment,
+                                 version, AccessUsage::Sampled,
+                                 rgc::SubresourceRange::mips(mip),
+                                 rgc::SubresourceRange::mips(mip - 1)));
+    version = downsamples.back();
+  }
+
+  // Same chain, reading previous level through read range of useDef
+  auto *reduced = new rgc::Allocation{mipped};
+  graph.push_back(reduced);
+  version = access(graph, reduced, AccessUsage::TransferDst, nc,
+                   AccessUsage::Unknown, rgc::SubresourceRange::mips(0));
+  std::vector<rgc::RealAction *> reductions;
+  for (std::uint16_t mip = 1; mip < 3; ++mip) {
+    auto *reduction = new rgc::RealAction{
+        version, nc, rgc::SubresourceRange::mips(mip), {},
+        rgc::SubresourceRange::mips(mip - 1)};
+    reduction->setAccess(AccessUsage::ColorAttachment);
+    reduction->setUseAccess(AccessUsage::Sampled);
+    graph.push_back(reduction);
+    reductions.push_back(reduction);
+    version = reduction;
+  }
+
+  // Shadow map is sampled through a Composition of lighting inputs
+  auto *shadow = new rgc::Allocation{color};
+  graph.push_back(shadow);
+  auto *shadowPass = access(graph, shadow, AccessUsage::ColorAttachment, nc,
+                            AccessUsage::Unknown);
+  rgc::Value *lightingInputs[] = {shadowPass, nc};
+  auto *inputs = new rgc::Composition{color, lightingInputs};
+  graph.push_back(inputs);
+  auto *shade = new rgc::Allocation{color};
+  graph.push_back(shade);
+  auto *shading = access(graph, shade, AccessUsage::ColorAttachment, inputs,
+                         AccessUsage::Sampled);
+
+  auto plan = rgc::planLayouts(graph);
+
+  // Both readers of g-buffer share one transition
+  assert(plan.layout(geometry, 0) == ImageLayout::ColorAttachment);
+  assert(plan.layout(ssao, 1) == ImageLayout::ShaderReadOnly);
+  assert(plan.layout(lighting, 1) == ImageLayout::ShaderReadOnly);
+  assert(countTransitions(plan, gbuffer) == 2);
+  assert(plan.layout(ssao, 0) == ImageLayout::General);
+  assert(countTransitions(plan, ao) == 2);
+  // hdr stays attachment while composited
+  assert(plan.layout(composite, 0) == ImageLayout::ColorAttachment);
+  assert(countTransitions(plan, hdr) == 2);
+
+  // Screen buffer ends up presentable
+  assert(plan.layout(present, 0) == ImageLayout::Present);
+  auto last = std::ranges::find(plan.transitions() | std::views::reverse,
+                                screen, &rgc::LayoutTransition::resource);
+  assert(last->before == present);
+  assert(last->from == ImageLayout::ColorAttachment);
+
+  // Each mip is written and then sampled by the next downsample
+  assert(plan.layout(downsamples[0], 0) == ImageLayout::ColorAttachment);
+  assert(plan.layout(downsamples[0], 1) == ImageLayout::ShaderReadOnly);
+  for (auto &transition : plan.transitions()) {
+    if (transition.resource != pyramid)
+      continue;
+    assert(transition.range.mipLevelCount == 1);
+    assert(transition.range.arrayLayerCount == 1);
+  }
+  // mip 0 and 1: written and sampled, mip 2: only written
+  assert(countTransitions(plan, pyramid) == 5);
+  assert(plan.layout(reductions[0], 0) == ImageLayout::ColorAttachment);
+  assert(plan.layout(reductions[0], 2) == ImageLayout::ShaderReadOnly);
+  assert(countTransitions(plan, reduced) == 5);
+
+  // Composed read gets its own transition out of attachment layout
+  assert(plan.layout(shading, 1) == ImageLayout::ShaderReadOnly);
+  assert(countTransitions(plan, shadow) == 2);
+  assert(std::ranges::any_of(plan.transitions(), [&](auto &t) {
+    return t.resource == shadow && t.before == shading &&
+           t.from == ImageLayout::ColorAttachment &&
+           t.to == ImageLayout::ShaderReadOnly;
+  }));
+
+  // Transitions follow graph order
+  std::unordered_map<const rgc::Action *, size_t> positions;
+  for (auto *action : graph)
+    positions.emplace(action, positions.size());
+  assert(std::ranges::is_sorted(plan.transitions(), {}, [&](auto &t) {
+    return positions.at(t.before);
+  }));
+}
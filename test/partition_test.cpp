@@ -0,0 +1,117 @@
+#include "rgc/Action.hpp"
+#include "rgc/Graph.hpp"
+#include "rgc/Partitioning.hpp"
+#include "rgc/Resolution.hpp"
+#include "rgc/ResourceIndex.hpp"
+#include "rgc/Types.hpp"
+#include <algorithm>
+
+namespace {
+
+double passCost(const rgc::Action *action) {
+  return action->actionKind() == rgc::Action::Kind::RealAction ? 1.0 : 0.0;
+}
+
+// Allocates buffer and modifies it 'passes' times, reading 'input' first
+rgc::RealAction *chain(rgc::Graph &graph, rgc::Type *type, rgc::Value *input,
+                       unsigned passes) {
+  auto *nc = graph.getConstant<rgc::NullConstant>(graph.types());
+  auto *allocation = new rgc::Allocation{type};
+  graph.push_back(allocation);
+  rgc::Value *version = allocation;
+  for (unsigned i = 0; i < passes; ++i) {
+    auto *pass = new rgc::RealAction{version, i == 0 ? input : nc};
+    graph.push_back(pass);
+    version = pass;
+  }
+  return static_cast<rgc::RealAction *>(version);
+}
+
+} // namespace
+
+int main() {
+  auto byteCost = 1e-6;
+  {
+    // Two independent pipelines are split between devices with no traffic
+    auto graph = rgc::Graph{};
+    auto *nc = graph.getConstant<rgc::NullConstant>(graph.types());
+    auto *buffer = graph.getType<rgc::BufferType>(
+        rgc::ScalarType::OwnerType::Device, 16u, 1024u);
+    std::vector<rgc::Action *> outputs;
+    for (unsigned pipeline = 0; pipeline < 2; ++pipeline) {
+      auto *first = chain(graph, buffer, nc, 4);
+      auto *second = chain(graph, buffer, first, 2);
+      graph.push_back(new rgc::Terminator{graph.types(), first});
+      graph.push_back(new rgc::Terminator{graph.types(), second});
+      outputs.push_back(second);
+    }
+
+    auto result = rgc::partitionGraph(graph, passCost);
+    assert(result.transfers.empty());
+    assert(result.loads[0] == 6.0 && result.loads[1] == 6.0);
+    assert(result.device(outputs[0]) != result.device(outputs[1]));
+    auto simulated = rgc::simulate(graph, result, passCost, byteCost);
+    assert(simulated.makespan == 6.0);
+  }
+  {
+    // Consumer of a single heavy producer is moved away for balance
+    auto graph = rgc::Graph{};
+    auto *nc = graph.getConstant<rgc::NullConstant>(graph.types());
+    auto *buffer = graph.getType<rgc::BufferType>(
+        rgc::ScalarType::OwnerType::Device, 16u, 1024u);
+    auto *producer = chain(graph, buffer, nc, 4);
+    auto *a = chain(graph, buffer, producer, 4);
+    auto *b = chain(graph, buffer, producer, 4);
+    auto *c = chain(graph, buffer, producer, 4);
+    for (auto *version : {producer, a, b, c})
+      graph.push_back(new rgc::Terminator{graph.types(), version});
+
+    auto result = rgc::partitionGraph(graph, passCost);
+    assert(result.loads[0] == 8.0 && result.loads[1] == 8.0);
+    assert(result.transfers.size() == 1);
+    auto *transfer = result.transfers.front();
+    assert(transfer->from() != transfer->to());
+    assert(result.transferredBytes == 16u * 1024u);
+    assert(result.device(transfer) == transfer->to());
+    // Every reader of producer reads it on its own device
+    auto index = rgc::ResourceIndex{graph};
+    for (auto *action : graph) {
+      auto *real = dynamic_cast<rgc::RealAction *>(action);
+      auto *read = real ? dynamic_cast<rgc::Action *>(real->getUse()) : nullptr;
+      if (read && !dynamic_cast<rgc::DeviceTransfer *>(real))
+        assert(result.device(read) == result.device(real));
+    }
+    assert(index.terminator(static_cast<rgc::Allocation *>(
+        transfer->getUseDef())));
+
+    auto simulated = rgc::simulate(graph, result, passCost, byteCost);
+    auto copyTime = 16u * 1024u * byteCost;
+    assert(simulated.busy[0] == 8.0 && simulated.busy[1] == 8.0);
+    assert(simulated.makespan > 12.0);
+    assert(simulated.makespan < 12.0 + 2 * copyTime);
+  }
+  {
+    // Screen sized images weigh their resolved size
+    auto graph = rgc::Graph{};
+    auto *nc = graph.getConstant<rgc::NullConstant>(graph.types());
+    auto *tied = graph.getType<rgc::TiedToScreenBufferImage>(
+        rgc::ImageType::PixelFormat::R8G8B8A8_UNORM, 0u);
+    auto *producer = chain(graph, tied, nc, 4);
+    auto *a = chain(graph, tied, producer, 4);
+    auto *b = chain(graph, tied, producer, 4);
+    auto *c = chain(graph, tied, producer, 4);
+    for (auto *version : {producer, a, b, c})
+      graph.push_back(new rgc::Terminator{graph.types(), version});
+
+    auto resolutions = rgc::ResolutionSet{};
+    resolutions.set(0u, 1920u, 1080u);
+    auto resolved = rgc::ResolvedGraph{graph, resolutions};
+    auto result =
+        rgc::partitionGraph(graph, passCost, {.resolved = &resolved});
+    assert(result.transfers.size() == 1);
+    assert(result.transferredBytes == 1920u * 1080u * 4u);
+    auto simulated =
+        rgc::simulate(graph, result, passCost, byteCost, &resolved);
+    assert(simulated.makespan > 8.0 + 1920u * 1080u * 4u * byteCost);
+  }
+}
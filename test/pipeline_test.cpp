@@ -0,0 +1,109 @@
+#include "rgc/Action.hpp"
+#include "rgc/Graph.hpp"
+#include "rgc/Pipelining.hpp"
+#include "rgc/Types.hpp"
+#include <algorithm>
+#include <vector>
+
+namespace {
+
+size_t extents[] = {64u, 64u, 1u};
+
+/// Frame that writes the Current copy of a persistent image and, if asked,
+/// reads History of it.
+struct Frame {
+  Frame(unsigned resourceID, bool readHistory) {
+    auto *type = graph.getType<rgc::AllocatedImageType>(
+        rgc::ImageType::PixelFormat::R16G16B16A16_SFLOAT,
+        rgc::ImageType::ExtentType::T2D, 1u, extents);
+    auto *nc = graph.getConstant<rgc::NullConstant>(graph.types());
+    current = new rgc::Import{type, resourceID};
+    graph.push_back(current);
+    rgc::Value *read = nc;
+    if (readHistory) {
+      history = new rgc::Import{type, resourceID, rgc::Import::Access::History};
+      graph.push_back(history);
+      read = history;
+    }
+    auto *write = new rgc::RealAction{current, read};
+    graph.push_back(write);
+    graph.push_back(new rgc::Terminator{graph.types(), write});
+    if (history)
+      graph.push_back(new rgc::Terminator{graph.types(), history});
+  }
+
+  rgc::Graph graph;
+  rgc::Import *current = nullptr;
+  rgc::Import *history = nullptr;
+};
+
+} // namespace
+
+int main() {
+  auto pipeline = rgc::FramePipeline{3u};
+  auto id = pipeline.addPersistent<rgc::AllocatedImageType>(
+      rgc::ImageType::PixelFormat::R16G16B16A16_SFLOAT,
+      rgc::ImageType::ExtentType::T2D, 1u, extents);
+
+  // Without History the resource has a single copy
+  std::vector<unsigned> written;
+  for (int i = 0; i < 2; ++i) {
+    auto frame = Frame{id, false};
+    auto plan = pipeline.beginFrame(frame.graph);
+    written.push_back(plan.bindings.at(frame.current).id);
+  }
+  assert(pipeline.copies(id) == 1);
+  assert(written[0] == written[1]);
+
+  // Ring grows to two copies once History is read. History of frame N is
+  // what frame N-1 wrote, even right after the ring has grown
+  for (int i = 0; i < 6; ++i) {
+    auto frame = Frame{id, true};
+    auto plan = pipeline.beginFrame(frame.graph);
+    auto current = plan.bindings.at(frame.current).id;
+    auto history = plan.bindings.at(frame.history).id;
+    assert(history == written.back());
+    assert(current != history);
+    written.push_back(current);
+  }
+  assert(pipeline.copies(id) == 2);
+
+  // A frame not touching the resource doesn't move History
+  {
+    auto idle = rgc::Graph{};
+    pipeline.beginFrame(idle);
+    auto frame = Frame{id, true};
+    auto plan = pipeline.beginFrame(frame.graph);
+    assert(plan.bindings.at(frame.history).id == written.back());
+  }
+
+  // Physical resources are released only once no frame in flight uses them
+  {
+    auto transients = rgc::FramePipeline{3u, 0u};
+    auto released = [](const rgc::FramePlan &plan, unsigned id) {
+      return std::ranges::count(plan.released, id,
+                                &rgc::PhysicalResource::id) == 1;
+    };
+    auto graph = rgc::Graph{};
+    auto *type = graph.getType<rgc::BufferType>(
+        rgc::ScalarType::OwnerType::Device, 4u, 4u);
+    auto *pooled = new rgc::Allocation{type};
+    auto *unterminated = new rgc::Allocation{type};
+    graph.push_back(pooled);
+    graph.push_back(unterminated);
+    graph.push_back(new rgc::Terminator{graph.types(), pooled});
+    auto plan = transients.beginFrame(graph);
+    auto pooledID = plan.bindings.at(pooled).id;
+    auto unterminatedID = plan.bindings.at(unterminated).id;
+    assert(pooledID != unterminatedID);
+    for (unsigned frame = 1; frame < 3u; ++frame) {
+      auto idle = rgc::Graph{};
+      plan = transients.beginFrame(idle);
+      assert(!released(plan, pooledID) && !released(plan, unterminatedID));
+    }
+    auto idle = rgc::Graph{};
+    plan = transients.beginFrame(idle);
+    assert(released(plan, pooledID) && released(plan, unterminatedID));
+  }
+  return 0;
+}
@@ -0,0 +1,85 @@
+#include "rgc/Action.hpp"
+#include "rgc/Graph.hpp"
+#include "rgc/Reordering.hpp"
+#include "rgc/Resolution.hpp"
+#include "rgc/Types.hpp"
+#include <algorithm>
+
+namespace {
+
+struct Frame {
+  rgc::Graph graph;
+  rgc::Allocation *a, *b, *c;
+  rgc::RealAction *workA, *workB;
+  rgc::Terminator *termA;
+  size_t imageSize;
+
+  // Everything is allocated upfront and terminated at the very end.
+  // Screen sized images are 1920x1080
+  explicit Frame(bool screenSized = false) {
+    auto *nc = graph.getConstant<rgc::NullConstant>(graph.types());
+    size_t extents[] = {256u, 256u, 1u};
+    rgc::Type *type = graph.getType<rgc::AllocatedImageType>(
+        rgc::ImageType::PixelFormat::R8G8B8A8_UNORM,
+        rgc::ImageType::ExtentType::T2D, 1u, extents);
+    imageSize = rgc::byteSize(type);
+    if (screenSized) {
+      type = graph.getType<rgc::TiedToScreenBufferImage>(
+          rgc::ImageType::PixelFormat::R8G8B8A8_UNORM, 0u);
+      imageSize = 1920u * 1080u * 4u;
+    }
+    a = new rgc::Allocation{type};
+    b = new rgc::Allocation{type};
+    c = new rgc::Allocation{type};
+    workA = new rgc::RealAction{a, nc};
+    workB = new rgc::RealAction{b, workA};
+    auto *workC = new rgc::RealAction{c, nc};
+    termA = new rgc::Terminator{graph.types(), workA};
+    auto *termB = new rgc::Terminator{graph.types(), workB};
+    auto *termC = new rgc::Terminator{graph.types(), workC};
+    for (auto *action : std::vector<rgc::Action *>{
+             a, b, c, workA, workB, workC, termA, termB, termC})
+      graph.push_back(action);
+  }
+
+  size_t position(rgc::Action *action) const {
+    auto found = std::find(graph.begin(), graph.end(), action);
+    return std::distance(graph.begin(), found);
+  }
+};
+
+} // namespace
+
+int main() {
+  {
+    auto frame = Frame{};
+    assert(rgc::peakMemory(frame.graph) == 3 * frame.imageSize);
+    auto report = rgc::reorderForMemory(frame.graph);
+    assert(report.peakBefore == 3 * frame.imageSize);
+    assert(report.peakAfter == 2 * frame.imageSize);
+    assert(rgc::peakMemory(frame.graph) == report.peakAfter);
+    assert(frame.graph.size() == 9);
+    // 'a' is alive until it is read by workB
+    assert(frame.position(frame.workB) < frame.position(frame.termA));
+    assert(frame.position(frame.workA) < frame.position(frame.b));
+  }
+  {
+    // Wave order keeps all allocations together
+    auto frame = Frame{};
+    auto report = rgc::reorderForMemory(frame.graph, {.maxWaveSkew = 0});
+    assert(report.peakAfter == 3 * frame.imageSize);
+    assert(frame.position(frame.c) < frame.position(frame.workA));
+  }
+  {
+    // Screen sized images weigh their resolved size
+    auto frame = Frame{true};
+    assert(rgc::peakMemory(frame.graph) == 0);
+    auto resolutions = rgc::ResolutionSet{};
+    resolutions.set(0u, 1920u, 1080u);
+    auto resolved = rgc::ResolvedGraph{frame.graph, resolutions};
+    assert(rgc::ownedBytes(frame.a, &resolved) == frame.imageSize);
+    auto report = rgc::reorderForMemory(frame.graph, {.resolved = &resolved});
+    assert(report.peakBefore == 3 * frame.imageSize);
+    assert(report.peakAfter == 2 * frame.imageSize);
+  }
+}
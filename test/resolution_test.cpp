@@ -0,0 +1,103 @@
+#include "rgc/Action.hpp"
+#include "rgc/Graph.hpp"
+#include "rgc/Resolution.hpp"
+#include "rgc/Types.hpp"
+#include <vector>
+
+int main() {
+  auto graph = rgc::Graph{};
+  auto *tied = graph.getType<rgc::TiedToScreenBufferImage>(
+      rgc::ImageType::PixelFormat::R8G8B8A8_UNORM, 0u);
+  auto *screen = graph.getType<rgc::ScreenBufferImage>(0u);
+  auto *a1 = new rgc::Allocation{tied};
+  auto *a2 = new rgc::Allocation{screen};
+  graph.push_back(a1);
+  graph.push_back(a2);
+  graph.push_back(new rgc::Terminator{graph.types(), a1});
+  graph.push_back(new rgc::Terminator{graph.types(), a2});
+
+  auto unresolved = rgc::ResolvedGraph{graph, rgc::ResolutionSet{}};
+  assert(!unresolved.complete());
+  assert(unresolved.byteSize(a1) == 0);
+
+  auto cache = rgc::SpecializationCache<size_t>{
+      [](const rgc::ResolvedGraph &resolved) {
+        assert(resolved.complete());
+        size_t total = 0;
+        for (auto *action : resolved.graph())
+          total += resolved.byteSize(action);
+        return total;
+      }};
+
+  auto hd = rgc::ResolutionSet{};
+  hd.set(0u, 1920u, 1080u);
+  auto low = rgc::ResolutionSet{};
+  low.set(0u, 1280u, 720u);
+
+  assert(cache.get(graph, hd) == 1920u * 1080u * 4u);
+  assert(cache.get(graph, low) == 1280u * 720u * 4u);
+  for (int frame = 0; frame < 10; ++frame) {
+    cache.get(graph, frame % 2 ? hd : low);
+  }
+  assert(cache.misses() == 2);
+
+  // Any mutation of the graph invalidates cached results
+  graph.push_back(new rgc::Allocation{tied});
+  cache.get(graph, hd);
+  assert(cache.misses() == 3);
+
+  // So does a change of action properties
+  auto hash = graph.structuralHash();
+  auto *write = new rgc::RealAction{a1, graph.getConstant<rgc::NullConstant>(
+                                            graph.types())};
+  graph.insertBefore(write, *std::next(graph.begin(), 2));
+  cache.get(graph, hd);
+  write->setAccess(rgc::AccessUsage::Storage);
+  assert(graph.structuralHash() != hash);
+  cache.get(graph, hd);
+  assert(cache.misses() == 5);
+
+  // Structurally equal graphs share results, graphs differing only in
+  // properties of an action don't
+  auto copy = rgc::Graph{};
+  auto *copyTied = copy.getType<rgc::TiedToScreenBufferImage>(
+      rgc::ImageType::PixelFormat::R8G8B8A8_UNORM, 0u);
+  auto *b1 = new rgc::Allocation{copyTied};
+  auto *b2 = new rgc::Allocation{copy.getType<rgc::ScreenBufferImage>(0u)};
+  auto *copyWrite = new rgc::RealAction{
+      b1, copy.getConstant<rgc::NullConstant>(copy.types())};
+  copyWrite->setAccess(rgc::AccessUsage::Storage);
+  for (auto *action : std::vector<rgc::Action *>{
+           b1, b2, copyWrite, new rgc::Terminator{copy.types(), b1},
+           new rgc::Terminator{copy.types(), b2},
+           new rgc::Allocation{copyTied}})
+    copy.push_back(action);
+  assert(copy.structuralKey() == graph.structuralKey());
+  cache.get(copy, hd);
+  assert(cache.misses() == 5);
+  copyWrite->setUseAccess(rgc::AccessUsage::Sampled);
+  assert(!(copy.structuralKey() == graph.structuralKey()));
+  cache.get(copy, hd);
+  assert(cache.misses() == 6);
+
+  // Graphs reading one external value twice and two different ones differ
+  auto *buffer = graph.getType<rgc::BufferType>(
+      rgc::ScalarType::OwnerType::Device, 4u, 4u);
+  auto *first = new rgc::Allocation{buffer};
+  auto *second = new rgc::Allocation{buffer};
+  auto reading = [&](rgc::Value *x, rgc::Value *y) {
+    auto external = rgc::Graph{};
+    auto *type = external.getType<rgc::BufferType>(
+        rgc::ScalarType::OwnerType::Device, 4u, 4u);
+    for (auto *input : {x, y}) {
+      auto *allocation = new rgc::Allocation{type};
+      external.push_back(allocation);
+      external.push_back(new rgc::RealAction{allocation, input});
+    }
+    return external.structuralKey();
+  };
+  assert(reading(first, second) == reading(second, first));
+  assert(!(reading(first, first) == reading(first, second)));
+  delete first;
+  delete second;
+}
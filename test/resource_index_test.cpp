@@ -0,0 +1,75 @@
+#include "rgc/Action.hpp"
+#include "rgc/Graph.hpp"
+#include "rgc/ResourceIndex.hpp"
+#include "rgc/Types.hpp"
+#include <algorithm>
+#include <iostream>
+
+namespace {
+
+rgc::Type *bufferType(rgc::Graph &graph) {
+  return graph.getType<rgc::BufferType>(rgc::ScalarType::OwnerType::Device, 4u,
+                                        4u);
+}
+
+bool contains(std::span<rgc::Action *const> actions, rgc::Action *action) {
+  return std::ranges::find(actions, action) != actions.end();
+}
+
+} // namespace
+
+int main() {
+  auto graph = rgc::Graph{};
+  auto index = rgc::ResourceIndex{graph};
+  auto *nc = graph.getConstant<rgc::NullConstant>(graph.types());
+
+  auto *a = new rgc::Allocation{bufferType(graph)};
+  auto *b = new rgc::Allocation{bufferType(graph)};
+  graph.push_back(a);
+  graph.push_back(b);
+
+  auto *a1 = new rgc::RealAction{a, nc};
+  auto *a2 = new rgc::RealAction{a1, nc};
+  graph.push_back(a1);
+  graph.push_back(a2);
+
+  // b1 reads second version of 'a' through composition
+  rgc::Value *composed[] = {a1, nc};
+  auto *comp = new rgc::Composition{a1->type(), composed};
+  graph.push_back(comp);
+  auto *b1 = new rgc::RealAction{b, comp};
+  graph.push_back(b1);
+
+  auto *ta = new rgc::Terminator{graph.types(), a2};
+  auto *tb = new rgc::Terminator{graph.types(), b1};
+  graph.push_back(ta);
+  graph.push_back(tb);
+
+  assert(std::ranges::equal(index.chain(a), std::array{a1, a2}));
+  assert(std::ranges::equal(index.chain(b), std::array{b1}));
+  assert(index.terminator(a) == ta);
+  assert(index.terminator(b) == tb);
+  assert(contains(index.readers(a), b1));
+  assert(index.readers(b).empty());
+  assert(index.resourceOf(a2) == a);
+  assert(index.resourceOf(tb) == b);
+  assert(index.resourceOf(comp) == nullptr);
+
+  // Insert new version in the middle of 'a' chain
+  auto *a15 = new rgc::RealAction{a1, nc};
+  graph.insertAfter(a15, a1);
+  a2->replaceUse(0, a15);
+  assert(std::ranges::equal(index.chain(a), std::array{a1, a15, a2}));
+
+  // Drop the read of 'a' from b1
+  comp->replaceAllUsesWith(nc);
+  assert(index.readers(a).empty());
+
+  graph.erase(comp);
+  assert(index.lastVersion(b) == b1);
+
+  for (auto *resource : index.resources()) {
+    resource->dump(std::cout);
+    std::cout << std::endl;
+  }
+}
@@ -0,0 +1,85 @@
+#include "rgc/StaticGraph.hpp"
+#include "rgc/Dependencies.hpp"
+#include "rgc/ResourceIndex.hpp"
+#include <algorithm>
+
+namespace {
+
+constexpr auto hdr = rgc::StaticType::image(
+    rgc::ImageType::PixelFormat::R16G16B16A16_SFLOAT,
+    rgc::ImageType::ExtentType::T2D, {64u, 64u, 1u});
+constexpr auto constants =
+    rgc::StaticType::buffer(rgc::ScalarType::OwnerType::Device, 16u, 16u);
+
+// Two post processing passes whose intermediates can share memory
+constexpr auto post = [] {
+  auto graph = rgc::StaticGraph<11>{};
+  auto params = graph.input(constants);
+  auto bloom = graph.allocate(hdr);
+  auto bloomDone = graph.modify(bloom, params);
+  auto tonemap = graph.allocate(hdr);
+  auto tonemapDone = graph.modify(tonemap, bloomDone);
+  graph.terminate(bloomDone);
+  auto graded = graph.modify(tonemapDone);
+  auto blur = graph.allocate(hdr);
+  auto blurDone = graph.modify(blur, graded);
+  graph.terminate(graded);
+  graph.terminate(blurDone);
+  return graph;
+}();
+
+constexpr auto compiled = rgc::compileStatic(post);
+
+static_assert(compiled.valid());
+static_assert(compiled.waveCount == 6);
+// 'blur' reuses memory of 'bloom'
+static_assert(compiled.heapSize == 2 * hdr.byteSize());
+static_assert(compiled.offset[7] == compiled.offset[1]);
+
+constexpr auto leaking = [] {
+  auto graph = rgc::StaticGraph<2>{};
+  graph.modify(graph.allocate(hdr));
+  return graph;
+}();
+static_assert(rgc::compileStatic(leaking).error ==
+              rgc::StaticGraphError::NotTerminated);
+
+constexpr auto forked = [] {
+  auto graph = rgc::StaticGraph<4>{};
+  auto image = graph.allocate(hdr);
+  graph.modify(image);
+  graph.terminate(image);
+  return graph;
+}();
+static_assert(rgc::compileStatic(forked).error ==
+              rgc::StaticGraphError::ForkedChain);
+
+} // namespace
+
+int main() {
+  auto graph = rgc::Graph{};
+  auto index = rgc::ResourceIndex{graph};
+  auto *params = new rgc::Allocation{constants.intern(graph)};
+  graph.push_back(params);
+
+  rgc::Value *inputs[] = {params};
+  auto values = rgc::splice(graph, compiled, inputs);
+  assert(values[0] == params);
+  // Spliced nodes plus the heap and its terminator
+  assert(graph.size() == post.nodes().size() + 2);
+  assert(index.readers(params).size() == 1);
+  assert(index.chain(static_cast<rgc::Allocation *>(values[1])).size() == 1);
+
+  // Memory plan survives: 'blur' aliases 'bloom' and is written only after
+  // 'bloom' is terminated
+  auto *bloom = dynamic_cast<rgc::SubAllocation *>(values[1]);
+  auto *blur = dynamic_cast<rgc::SubAllocation *>(values[7]);
+  assert(bloom && blur && bloom->block() == blur->block());
+  assert(bloom->offset() == blur->offset());
+  auto dependencies = rgc::DependencyGraph{graph, index};
+  auto *blurDone = static_cast<rgc::Action *>(values[8]);
+  assert(std::ranges::count(dependencies.dependencies(blurDone), values[5]) ==
+         1);
+
+  graph.push_back(new rgc::Terminator{graph.types(), params});
+}
@@ -0,0 +1,122 @@
+#include "rgc/Action.hpp"
+#include "rgc/Graph.hpp"
+#include "rgc/Suballocation.hpp"
+#include "rgc/Types.hpp"
+#include <algorithm>
+#include <numeric>
+#include <vector>
+
+namespace {
+
+constexpr auto Host = rgc::ScalarType::OwnerType::Host;
+constexpr auto Device = rgc::ScalarType::OwnerType::Device;
+
+const rgc::BufferType *bufferOf(const rgc::Value *value) {
+  return static_cast<const rgc::BufferType *>(value->type());
+}
+
+} // namespace
+
+int main() {
+  auto graph = rgc::Graph{};
+  auto *nc = graph.getConstant<rgc::NullConstant>(graph.types());
+  auto buffer = [&](rgc::ScalarType::OwnerType owner, size_t elementSize,
+                    size_t count) {
+    auto *allocation = new rgc::Allocation{
+        graph.getType<rgc::BufferType>(owner, elementSize, count)};
+    graph.push_back(allocation);
+    auto *write = new rgc::RealAction{allocation, nc};
+    graph.push_back(write);
+    graph.push_back(new rgc::Terminator{graph.types(), write});
+    return allocation;
+  };
+  buffer(Device, 4u, 5u);
+  buffer(Device, 64u, 2u);
+  buffer(Device, 8u, 10u);
+  buffer(Host, 16u, 4u);
+  buffer(Host, 2u, 3u);
+  // Too large to share a block
+  auto *large = buffer(Device, 16u, 64u * 1024u);
+
+  auto result = rgc::suballocateBuffers(graph);
+  assert(result.blocks.size() == 2);
+  assert(result.suballocated == 5);
+  assert(graph.contains(large));
+
+  std::vector<rgc::SubAllocation *> subs;
+  for (auto *action : graph)
+    if (auto *sub = dynamic_cast<rgc::SubAllocation *>(action))
+      subs.push_back(sub);
+  assert(subs.size() == 5);
+
+  for (auto *block : result.blocks) {
+    auto *type = bufferOf(block);
+    std::vector<rgc::SubAllocation *> members;
+    std::ranges::copy_if(subs, std::back_inserter(members),
+                         [&](auto *sub) { return sub->block() == block; });
+    assert(!members.empty());
+
+    // Every buffer is aligned to its element size and to 16 bytes, and
+    // block's element size is a multiple of every alignment of them
+    size_t strictest = 1;
+    for (auto *sub : members) {
+      auto alignment = std::lcm<size_t>(bufferOf(sub)->elementSize(), 16u);
+      assert(sub->offset() % alignment == 0);
+      assert(bufferOf(sub)->ownerType() == type->ownerType());
+      strictest = std::lcm(strictest, alignment);
+    }
+    assert(type->elementSize() == strictest);
+
+    // Buffers are packed in order, don't alias and fit into the block
+    std::ranges::sort(members, {}, &rgc::SubAllocation::offset);
+    for (size_t i = 0; i < members.size(); ++i) {
+      auto end = members[i]->offset() + bufferOf(members[i])->byteSize();
+      assert(end <= type->byteSize());
+      if (i + 1 < members.size()) {
+        assert(end <= members[i + 1]->offset());
+        assert(members[i + 1]->offset() - end < strictest);
+      }
+    }
+  }
+  auto *device = bufferOf(result.blocks[0])->ownerType() == Device
+                     ? result.blocks[0]
+                     : result.blocks[1];
+  // 20 bytes at 0, 128 at 64 and 80 at 192
+  assert(bufferOf(device)->elementSize() == 64u);
+  assert(bufferOf(device)->byteSize() == 320u);
+
+  // Stride which is not a power of two is kept a multiple of its element
+  // size and buffers needing too strict alignment keep their own
+  {
+    auto strided = rgc::Graph{};
+    auto *snc = strided.getConstant<rgc::NullConstant>(strided.types());
+    auto add = [&](size_t elementSize, size_t count) {
+      auto *allocation = new rgc::Allocation{
+          strided.getType<rgc::BufferType>(Device, elementSize, count)};
+      strided.push_back(allocation);
+      auto *write = new rgc::RealAction{allocation, snc};
+      strided.push_back(write);
+      strided.push_back(new rgc::Terminator{strided.types(), write});
+      return allocation;
+    };
+    add(4u, 5u);
+    add(24u, 2u);
+    auto *wide = add(80u, 1u);
+    auto *odd = add(24u, 1u);
+    auto options = rgc::SuballocationOptions{.maxAlignment = 64u};
+    auto stridedResult = rgc::suballocateBuffers(strided, options);
+    // 80 bytes need 80-byte offsets, 24 and 16 combine to 48
+    assert(strided.contains(wide));
+    assert(stridedResult.blocks.size() == 1);
+    assert(stridedResult.suballocated == 3);
+    assert(!strided.contains(odd));
+    auto *block = stridedResult.blocks.front();
+    assert(bufferOf(block)->elementSize() == 48u);
+    for (auto *action : strided)
+      if (auto *sub = dynamic_cast<rgc::SubAllocation *>(action))
+        assert(sub->offset() % bufferOf(sub)->elementSize() == 0);
+    // 20 bytes at 0, 48 at 48 and 24 at 96
+    assert(bufferOf(block)->byteSize() == 144u);
+  }
+  return 0;
+}
@@ -0,0 +1,101 @@
+#include "rgc/Action.hpp"
+#include "rgc/Graph.hpp"
+#include "rgc/Reordering.hpp"
+#include "rgc/ResourceIndex.hpp"
+#include "rgc/Templates.hpp"
+#include "rgc/Types.hpp"
+
+namespace {
+
+struct InsertCounter : rgc::GraphObserver {
+  void actionsInserted(std::span<rgc::Action *const> actions) override {
+    ++batches;
+    inserted += actions.size();
+  }
+
+  unsigned batches = 0;
+  size_t inserted = 0;
+};
+
+} // namespace
+
+int main() {
+  auto graph = rgc::Graph{};
+  auto index = rgc::ResourceIndex{graph};
+  auto counter = InsertCounter{};
+  size_t extents[] = {1024u, 1024u, 1u};
+  auto *depth = graph.getType<rgc::AllocatedImageType>(
+      rgc::ImageType::PixelFormat::R32_SFLOAT,
+      rgc::ImageType::ExtentType::T2D, 1u, extents);
+  auto *atlasType = graph.getType<rgc::AllocatedImageType>(
+      rgc::ImageType::PixelFormat::R32_SFLOAT,
+      rgc::ImageType::ExtentType::T2D, 1u, extents, 4u);
+  auto *scene = graph.getType<rgc::BufferType>(
+      rgc::ScalarType::OwnerType::Device, 64u, 1024u);
+
+  auto *geometry = new rgc::Allocation{scene};
+  auto *atlas = new rgc::Allocation{atlasType};
+  graph.push_back(geometry);
+  graph.push_back(atlas);
+
+  // Cascade: render depth of the scene, then resolve it into the atlas
+  auto *cascade = new rgc::Allocation{depth};
+  auto *render = new rgc::RealAction{cascade, geometry};
+  render->setAccess(rgc::AccessUsage::DepthStencilAttachment);
+  auto *resolve = new rgc::RealAction{atlas, render};
+  auto *drop = new rgc::Terminator{graph.types(), render};
+  rgc::Action *pattern[] = {cascade, render, resolve, drop};
+  rgc::Value *parameters[] = {atlas};
+  auto cascadeTemplate = rgc::SubgraphTemplate{pattern, parameters};
+  assert(cascadeTemplate.prototypes().size() == 4);
+  assert(cascadeTemplate.parameterCount() == 1);
+  for (auto *action : pattern | std::views::reverse)
+    delete action;
+
+  // Chain four cascades through the atlas
+  rgc::Value *version = atlas;
+  std::vector<rgc::SubgraphInstance> instances;
+  graph.addObserver(&counter);
+  for (unsigned i = 0; i < 4; ++i) {
+    rgc::Value *arguments[] = {version};
+    instances.push_back(cascadeTemplate.instantiate(graph, arguments));
+    version = instances.back()[2];
+  }
+  graph.removeObserver(&counter);
+  // Every instance is inserted with a single notification
+  assert(counter.batches == 4 && counter.inserted == 4 * 4);
+  graph.push_back(new rgc::Terminator{graph.types(), version});
+  graph.push_back(new rgc::Terminator{graph.types(), geometry});
+  assert(graph.size() == 2 + 4 * 4 + 2);
+
+  auto &first = instances.front();
+  auto *firstRender = static_cast<rgc::RealAction *>(first[1]);
+  assert(first[0]->type() == depth);
+  assert(firstRender->getUseDef() == first[0]);
+  assert(firstRender->getUse() == geometry);
+  assert(firstRender->access() == rgc::AccessUsage::DepthStencilAttachment);
+  assert(index.chain(atlas).size() == 4);
+  assert(index.readers(geometry).size() == 4);
+  assert(index.terminator(static_cast<rgc::Allocation *>(instances[3][0])) ==
+         instances[3][3]);
+
+  // Template body is a graph on its own and analyses over it are shared
+  unsigned computed = 0;
+  auto peak = [&](rgc::Graph &body) {
+    ++computed;
+    return rgc::peakMemory(body);
+  };
+  for (auto &instance : instances) {
+    auto &bodyPeak = instance.source().analysis<size_t>(peak);
+    (void)bodyPeak;
+  }
+  assert(computed == 1);
+  auto count = [](rgc::Graph &body) { return body.size(); };
+  auto &bodySize = cascadeTemplate.analysis<size_t>(count);
+  assert(bodySize == cascadeTemplate.body().size());
+  assert(cascadeTemplate.analysis<size_t>(peak) != bodySize);
+  assert(computed == 1);
+  auto *bodyCascade = cascadeTemplate.prototypes()[0];
+  assert(cascadeTemplate.indexOf(bodyCascade) == 0);
+  assert(cascadeTemplate.body().contains(bodyCascade));
+}
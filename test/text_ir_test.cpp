@@ -0,0 +1,149 @@
+#include <memory>
+#include <sstream>
+#include <string>
+
+#include "rgc/Action.hpp"
+#include "rgc/Graph.hpp"
+#include "rgc/Partitioning.hpp"
+#include "rgc/Pipelining.hpp"
+#include "rgc/Suballocation.hpp"
+#include "rgc/TextIR.hpp"
+#include "rgc/Transfer.hpp"
+#include "rgc/Types.hpp"
+
+int main() {
+  auto graph = rgc::Graph{};
+  auto *nc = graph.getConstant<rgc::NullConstant>(graph.types());
+  size_t extents[] = {512u, 512u, 1u};
+  auto *imageType = graph.getType<rgc::AllocatedImageType>(
+      rgc::ImageType::PixelFormat::R8G8B8A8_UNORM,
+      rgc::ImageType::ExtentType::T2D, 4u, extents, 6u);
+  auto *screenType = graph.getType<rgc::ScreenBufferImage>(0u);
+  auto *tiedType = graph.getType<rgc::TiedToScreenBufferImage>(
+      rgc::ImageType::PixelFormat::R32_SFLOAT, 0u);
+  auto *hostBuffer = graph.getType<rgc::BufferType>(
+      rgc::ScalarType::OwnerType::Host, 16u, 256u);
+  auto *deviceBuffer = graph.getType<rgc::BufferType>(
+      rgc::ScalarType::OwnerType::Device, 16u, 256u);
+
+  auto *image = new rgc::Allocation{imageType};
+  auto *screen = new rgc::Import{screenType, 3u};
+  auto *depth = new rgc::Allocation{tiedType};
+  auto *staging = new rgc::Allocation{hostBuffer};
+  auto *block = new rgc::Allocation{deviceBuffer};
+  auto *buffer = new rgc::SubAllocation{deviceBuffer, block, 128u};
+  auto *upload =
+      new rgc::Transfer{buffer, staging, rgc::Transfer::Direction::Upload};
+  upload->setStaging(2u, 4096u);
+  upload->setAccess(rgc::AccessUsage::TransferDst);
+  auto *face = new rgc::RealAction{image, upload,
+                                   rgc::SubresourceRange{1u, 2u, 3u, 1u}};
+  face->setAccess(rgc::AccessUsage::ColorAttachment);
+  face->setUseAccess(rgc::AccessUsage::Storage);
+  auto *mips = new rgc::RealAction{face, nc, rgc::SubresourceRange::mips(1),
+                                   {}, rgc::SubresourceRange::mips(0)};
+  rgc::Value *targets[] = {screen, depth};
+  auto *framebuffer = new rgc::Composition{imageType, targets};
+  auto *draw = new rgc::RealAction{screen, mips};
+  auto *copy = new rgc::Allocation{imageType};
+  auto *send = new rgc::DeviceTransfer{copy, mips, 0u, 1u};
+  auto *dynamic = new rgc::Allocation{imageType, framebuffer};
+  for (auto *action : std::vector<rgc::Action *>{
+           image, screen, depth, staging, block, buffer, upload, face, mips,
+           framebuffer, draw, copy, send, dynamic})
+    graph.push_back(action);
+  for (auto *value : std::vector<rgc::Value *>{
+           draw, depth, upload, staging, block, send, mips, dynamic})
+    graph.push_back(new rgc::Terminator{graph.types(), value});
+
+  auto text = std::ostringstream{};
+  rgc::printGraph(graph, text);
+  auto source = std::istringstream{text.str()};
+  auto copyGraph = rgc::Graph{};
+  auto parser = rgc::GraphParser{copyGraph};
+  assert(parser.parse(source));
+  assert(parser.error().empty());
+  assert(copyGraph.size() == graph.size());
+  assert(copyGraph.structuralHash() == graph.structuralHash());
+
+  // Printing is deterministic, so the round trip is exact
+  auto again = std::ostringstream{};
+  rgc::printGraph(copyGraph, again);
+  assert(again.str() == text.str());
+
+  auto *parsedFace =
+      static_cast<rgc::RealAction *>(*std::next(copyGraph.begin(), 7));
+  assert(parsedFace->range() == face->range());
+  assert(parsedFace->useAccess() == rgc::AccessUsage::Storage);
+  auto *parsedMips = static_cast<rgc::RealAction *>(parsedFace->getNextNode());
+  assert(parsedMips->readRange() == mips->readRange());
+
+  // Values from outside of the graph are declared and bound on parsing
+  {
+    auto params = std::make_unique<rgc::Allocation>(deviceBuffer);
+    auto external = rgc::Graph{};
+    auto *target = new rgc::Allocation{deviceBuffer};
+    external.push_back(target);
+    auto *write = new rgc::RealAction{target, params.get()};
+    external.push_back(write);
+    external.push_back(new rgc::Terminator{external.types(), write});
+    auto printed = std::ostringstream{};
+    rgc::printGraph(external, printed);
+    assert(printed.str() == "!0 = buffer device 16x256\n"
+                            "%0 = alloc !0\n"
+                            "$0 = external !0\n"
+                            "%1 = real %0, $0\n"
+                            "%2 = terminate %1\n");
+
+    rgc::Value *bound[] = {params.get()};
+    auto reparsed = rgc::Graph{};
+    auto is = std::istringstream{printed.str()};
+    auto binding = rgc::GraphParser{reparsed, bound};
+    assert(binding.parse(is));
+    auto *read = static_cast<rgc::RealAction *>(*std::next(reparsed.begin()));
+    assert(read->getUse() == params.get());
+
+    auto unbound = rgc::Graph{};
+    is = std::istringstream{printed.str()};
+    auto missing = rgc::GraphParser{unbound};
+    assert(!missing.parse(is) && missing.line() == 3);
+  }
+
+  // Parsing stops at the first malformed line
+  auto broken = std::istringstream{"; comment\n"
+                                   "!0 = buffer device 16x4\n"
+                                   "%0 = alloc !0\n"
+                                   "%1 = real %0, %2\n"
+                                   "%2 = terminate %0\n"};
+  auto partial = rgc::Graph{};
+  auto failing = rgc::GraphParser{partial};
+  assert(!failing.parse(broken));
+  assert(failing.line() == 4);
+  assert(!failing.error().empty());
+  assert(partial.size() == 1);
+
+  // Operands of wrong kinds and ranges out of resources are rejected
+  for (auto *invalid : {"%0 = alloc !0\n"
+                        "%1 = terminate null\n",
+                        "%0 = alloc !0\n"
+                        "%1 = terminate %0\n"
+                        "%2 = real %1, null\n",
+                        "%0 = alloc !0\n"
+                        "%1 = alloc !0 %0\n",
+                        "%0 = alloc !0\n"
+                        "%1 = real %0[9:1, 0:1], null\n",
+                        "%0 = alloc !0\n"
+                        "%1 = real %0, %0[0:1, 1:1]\n",
+                        "%0 = alloc !0\n"
+                        "%1 = compose !0 %0\n"
+                        "%2 = real %1, null\n"}) {
+    auto is = std::istringstream{std::string{"!0 = buffer device 16x4\n"} +
+                                 invalid};
+    auto rejected = rgc::Graph{};
+    auto semantic = rgc::GraphParser{rejected};
+    assert(!semantic.parse(is));
+    assert(semantic.error() != "malformed operands");
+    assert(!semantic.error().empty());
+  }
+  return 0;
+}
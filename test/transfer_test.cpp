@@ -0,0 +1,105 @@
+#include "rgc/Action.hpp"
+#include "rgc/Graph.hpp"
+#include "rgc/Transfer.hpp"
+#include "rgc/Types.hpp"
+#include <vector>
+
+namespace {
+
+constexpr auto Host = rgc::ScalarType::OwnerType::Host;
+constexpr auto Device = rgc::ScalarType::OwnerType::Device;
+
+bool isTransfer(rgc::Value *value) {
+  return dynamic_cast<rgc::Transfer *>(value) != nullptr;
+}
+
+} // namespace
+
+int main() {
+  // Direct reads, reads through a Composition and by a dynamic Allocation
+  {
+    auto graph = rgc::Graph{};
+    auto *hostType = graph.getType<rgc::BufferType>(Host, 4u, 64u);
+    auto *deviceType = graph.getType<rgc::BufferType>(Device, 4u, 64u);
+    auto *h1 = new rgc::Allocation{hostType};
+    auto *h2 = new rgc::Allocation{hostType};
+    auto *h3 = new rgc::Allocation{hostType};
+    auto *d = new rgc::Allocation{deviceType};
+    graph.push_back(h1);
+    graph.push_back(h2);
+    graph.push_back(h3);
+    graph.push_back(d);
+    auto *r1 = new rgc::RealAction{d, h1};
+    graph.push_back(r1);
+    rgc::Value *members[] = {h2};
+    auto *composition = new rgc::Composition{hostType, members};
+    graph.push_back(composition);
+    auto *r2 = new rgc::RealAction{r1, composition};
+    graph.push_back(r2);
+    rgc::Value *size[] = {h3};
+    auto *sizeOf = new rgc::Composition{hostType, size};
+    graph.push_back(sizeOf);
+    auto *dynamic = new rgc::Allocation{deviceType, sizeOf};
+    graph.push_back(dynamic);
+    graph.push_back(new rgc::Terminator{graph.types(), r2});
+    graph.push_back(new rgc::Terminator{graph.types(), dynamic});
+
+    auto plan = rgc::planTransfers(graph);
+    assert(plan.oversized.empty());
+    assert(plan.batches.size() == 1);
+    assert(plan.batches[0].transfers.size() == 3);
+    assert(plan.batches[0].waits.empty());
+    assert(isTransfer(r1->getUse()));
+    assert(isTransfer(composition->uses()[0]));
+    assert(isTransfer(sizeOf->uses()[0]));
+    // Readers of the Composition still read it, not the transfer
+    assert(r2->getUse() == composition);
+  }
+
+  // Staging memory of a batch is reused only after it is complete, and
+  // buffers larger than the whole ring are not transferred
+  {
+    auto graph = rgc::Graph{};
+    auto *nc = graph.getConstant<rgc::NullConstant>(graph.types());
+    auto *hostType = graph.getType<rgc::BufferType>(Host, 4u, 64u);
+    auto *deviceType = graph.getType<rgc::BufferType>(Device, 4u, 64u);
+    auto *hugeType = graph.getType<rgc::BufferType>(Host, 4u, 1024u);
+    rgc::Value *target = new rgc::Allocation{deviceType};
+    graph.push_back(static_cast<rgc::Action *>(target));
+    std::vector<rgc::RealAction *> consumers;
+    for (int i = 0; i < 4; ++i) {
+      // Every source is written right before its consumer, so each of them
+      // needs a batch of its own
+      auto *source = new rgc::Allocation{hostType};
+      graph.push_back(source);
+      auto *write = new rgc::RealAction{source, nc};
+      graph.push_back(write);
+      consumers.push_back(new rgc::RealAction{target, write});
+      graph.push_back(consumers.back());
+      target = consumers.back();
+    }
+    auto *huge = new rgc::Allocation{hugeType};
+    graph.push_back(huge);
+    auto *last = new rgc::RealAction{target, huge};
+    graph.push_back(last);
+    graph.push_back(new rgc::Terminator{graph.types(), last});
+
+    auto options = rgc::TransferOptions{};
+    options.stagingSize = 512u;
+    options.alignment = 256u;
+    auto plan = rgc::planTransfers(graph, options);
+    assert(plan.batches.size() == 4);
+    std::vector<unsigned> expected[] = {{}, {}, {0u}, {1u}};
+    for (unsigned i = 0; i < 4; ++i) {
+      auto &batch = plan.batches[i];
+      assert(batch.transfers.size() == 1);
+      assert(batch.transfers[0]->batch() == i);
+      assert(batch.transfers[0]->stagingOffset() == i % 2u * 256u);
+      assert(batch.waits == expected[i]);
+      assert(consumers[i]->getUse() == batch.transfers[0]);
+    }
+    assert(plan.oversized.size() == 1 && plan.oversized[0] == huge);
+    assert(last->getUse() == huge);
+  }
+  return 0;
+}
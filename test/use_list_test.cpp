@@ -0,0 +1,99 @@
+#include "rgc/Action.hpp"
+#include "rgc/Graph.hpp"
+#include "rgc/Types.hpp"
+#include <algorithm>
+#include <vector>
+
+namespace {
+
+size_t countUses(rgc::Value *value) {
+  return std::ranges::distance(value->users());
+}
+
+bool usedAt(rgc::Value *value, rgc::Action *user, unsigned index) {
+  return std::ranges::any_of(value->users(), [&](auto &use) {
+    return use.user() == user && use.index() == index;
+  });
+}
+
+} // namespace
+
+int main() {
+  auto graph = rgc::Graph{};
+  auto *nc = graph.getConstant<rgc::NullConstant>(graph.types());
+  auto *type = graph.getType<rgc::BufferType>(
+      rgc::ScalarType::OwnerType::Device, 4u, 4u);
+
+  auto *a = new rgc::Allocation{type};
+  auto *b = new rgc::Allocation{type};
+  graph.push_back(a);
+  graph.push_back(b);
+  assert(a->allocationKind() == rgc::Allocation::Kind::Static);
+  assert(a->operands().empty());
+
+  // Every kind of action finds its uses and every use its user and index
+  auto *write = new rgc::RealAction{a, b};
+  graph.push_back(write);
+  assert(usedAt(a, write, 0) && usedAt(b, write, 1));
+  rgc::Value *members[] = {write, b, write};
+  auto *composition = new rgc::Composition{type, members};
+  graph.push_back(composition);
+  assert(usedAt(write, composition, 0) && usedAt(b, composition, 1) &&
+         usedAt(write, composition, 2));
+  auto *dynamic = new rgc::Allocation{type, composition};
+  graph.push_back(dynamic);
+  assert(dynamic->allocationKind() == rgc::Allocation::Kind::Dynamic);
+  assert(usedAt(composition, dynamic, 0));
+  auto *terminator = new rgc::Terminator{graph.types(), dynamic};
+  graph.push_back(terminator);
+  assert(usedAt(dynamic, terminator, 0));
+  assert(countUses(write) == 2 && countUses(b) == 2);
+
+  // Large blocks of uses still map every use back to its position
+  std::vector<rgc::Value *> many(300u, nc);
+  for (size_t i = 0; i < many.size(); i += 7)
+    many[i] = a;
+  auto *wide = new rgc::Composition{type, many};
+  for (auto &use : wide->operands()) {
+    assert(use.user() == wide);
+    assert(&wide->operands()[use.index()] == &use);
+  }
+  for (auto &use : a->users())
+    assert(use.user() != wide || use.index() % 7u == 0);
+  delete wide;
+  assert(countUses(a) == 1);
+
+  // Replacing a use relinks it without touching other uses
+  write->replaceUse(1, nc);
+  assert(write->getUse() == nc && !usedAt(b, write, 1));
+  assert(countUses(b) == 1 && usedAt(b, composition, 1));
+
+  // RAUW moves every use, including both uses by the same user
+  auto *copy = new rgc::RealAction{b, nc};
+  graph.insertAfter(copy, write);
+  write->replaceAllUsesWith(copy);
+  assert(write->unused());
+  assert(usedAt(copy, composition, 0) && usedAt(copy, composition, 2));
+  assert(composition->uses()[0] == copy && composition->uses()[2] == copy);
+  assert(countUses(copy) == 2);
+
+  // Erasing an unused action unlinks its uses from their values
+  auto before = countUses(nc);
+  graph.erase(write);
+  assert(countUses(nc) == before - 1);
+  assert(countUses(a) == 0);
+
+  // Clones use given operands and keep properties of the original
+  copy->setAccess(rgc::AccessUsage::TransferDst);
+  copy->setUseAccess(rgc::AccessUsage::Sampled);
+  rgc::Value *operands[] = {a, b};
+  auto *clone = static_cast<rgc::RealAction *>(copy->clone(operands));
+  assert(clone->access() == rgc::AccessUsage::TransferDst);
+  assert(clone->useAccess() == rgc::AccessUsage::Sampled);
+  assert(usedAt(a, clone, 0) && usedAt(b, clone, 1));
+  delete clone;
+  assert(countUses(a) == 0);
+
+  // Tear down releases actions still in use by others
+  return 0;
+}
@@ -0,0 +1,105 @@
+// Rebuilds a graph from a journal recorded by rgc::GraphJournal and runs
+// compilation passes over it, reporting time spent in each one. Meant to be
+// run under a profiler to reproduce performance problems of graphs built
+// elsewhere:
+//
+//   rgc-replay graph.rgcj [--repeat N]
+//
+// Every repetition replays the journal from scratch, since some passes
+// mutate the graph.
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <string>
+
+#include "rgc/Dependencies.hpp"
+#include "rgc/Journal.hpp"
+#include "rgc/Layouts.hpp"
+#include "rgc/Reordering.hpp"
+#include "rgc/ResourceIndex.hpp"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+class Timings {
+public:
+  template <typename F> void measure(const std::string &stage, F &&f) {
+    auto start = Clock::now();
+    f();
+    m_total[stage] += Clock::now() - start;
+    m_order.emplace(stage, m_order.size());
+  }
+
+  void report(std::ostream &os, unsigned repeat) const {
+    std::multimap<size_t, std::string> stages;
+    for (auto &&[stage, order] : m_order)
+      stages.emplace(order, stage);
+    for (auto &&[order, stage] : stages) {
+      auto ms =
+          std::chrono::duration<double, std::milli>(m_total.at(stage)).count();
+      os << stage << ": " << ms / repeat << " ms\n";
+    }
+  }
+
+private:
+  std::map<std::string, Clock::duration> m_total;
+  std::map<std::string, size_t> m_order;
+};
+
+} // namespace
+
+int main(int argc, char **argv) {
+  const char *path = nullptr;
+  unsigned repeat = 1;
+  for (int i = 1; i < argc; ++i) {
+    if (!std::strcmp(argv[i], "--repeat") && i + 1 < argc)
+      repeat = std::max(1, std::atoi(argv[++i]));
+    else
+      path = argv[i];
+  }
+  if (!path) {
+    std::cerr << "usage: " << argv[0] << " <journal> [--repeat N]\n";
+    return 1;
+  }
+
+  auto timings = Timings{};
+  for (unsigned i = 0; i < repeat; ++i) {
+    auto file = std::ifstream{path, std::ios::binary};
+    if (!file) {
+      std::cerr << "cannot open " << path << "\n";
+      return 1;
+    }
+    auto replay = rgc::JournalReplay{file};
+    auto replayed = false;
+    timings.measure("replay", [&] { replayed = replay.run(); });
+    if (!replayed) {
+      std::cerr << path << ": record " << replay.records() + 1 << ": "
+                << replay.error() << "\n";
+      return 1;
+    }
+    auto &graph = replay.graph();
+    if (i == 0)
+      std::cout << replay.records() << " records, " << graph.size()
+                << " actions\n";
+
+    timings.measure("resource index + dependencies", [&] {
+      auto index = rgc::ResourceIndex{graph};
+      auto dependencies = rgc::DependencyGraph{graph, index};
+      dependencies.waves();
+    });
+    timings.measure("layouts", [&] { rgc::planLayouts(graph); });
+    timings.measure("reorder", [&] {
+      auto report = rgc::reorderForMemory(graph);
+      if (i == 0)
+        std::cout << "peak memory " << report.peakBefore << " -> "
+                  << report.peakAfter << " bytes\n";
+    });
+  }
+  timings.report(std::cout, repeat);
+  return 0;
+}